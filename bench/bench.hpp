@@ -0,0 +1,229 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_BENCH_MARCH_10_2019)
+#define CYCFI_PHOTON_BENCH_MARCH_10_2019
+
+#include <photon/support/canvas.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cycfi { namespace photon { namespace bench
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Timing
+   ////////////////////////////////////////////////////////////////////////////
+   using clock = std::chrono::steady_clock;
+
+   struct stats
+   {
+      std::size_t    iterations = 0;
+      double         mean_us = 0;
+      double         median_us = 0;
+      double         min_us = 0;
+      double         max_us = 0;
+   };
+
+   // Run f at least once and at most max_iterations times, stopping early
+   // when the time budget is used up. Each run is timed on its own.
+   template <typename F>
+   stats measure(F f, std::size_t max_iterations, double budget_ms = 500)
+   {
+      std::vector<double> times;
+      auto start = clock::now();
+      do
+      {
+         auto t0 = clock::now();
+         f();
+         auto t1 = clock::now();
+         times.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+      }
+      while (times.size() < max_iterations
+         && std::chrono::duration<double, std::milli>(clock::now() - start).count() < budget_ms);
+
+      std::sort(times.begin(), times.end());
+      stats s;
+      s.iterations = times.size();
+      for (auto t : times)
+         s.mean_us += t;
+      s.mean_us /= times.size();
+      s.median_us = times[times.size() / 2];
+      s.min_us = times.front();
+      s.max_us = times.back();
+      return s;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Reporting
+   ////////////////////////////////////////////////////////////////////////////
+   inline std::string quote(std::string const& s)
+   {
+      std::string r = "\"";
+      for (auto c : s)
+      {
+         if (c == '"' || c == '\\')
+            r += '\\';
+         r += c;
+      }
+      return r + '"';
+   }
+
+   // A benchmark parameter, kept as a ready to write JSON value
+   struct param
+   {
+      param(char const* name_, std::string const& value_)
+       : name(name_), value(quote(value_)) {}
+
+      param(char const* name_, char const* value_)
+       : name(name_), value(quote(value_)) {}
+
+      template <typename T>
+      param(char const* name_, T value_)
+       : name(name_), value(std::to_string(value_)) {}
+
+      std::string    name;
+      std::string    value;
+   };
+
+   class report
+   {
+   public:
+
+      report(char const* suite)
+       : _suite(suite)
+      {}
+
+      void add(char const* name, std::vector<param> const& params, stats const& s)
+      {
+         std::ostringstream out;
+         out << "    { \"name\": " << quote(name);
+         for (auto const& p : params)
+            out << ", " << quote(p.name) << ": " << p.value;
+         out << ", \"iterations\": " << s.iterations
+             << ", \"mean_us\": " << s.mean_us
+             << ", \"median_us\": " << s.median_us
+             << ", \"min_us\": " << s.min_us
+             << ", \"max_us\": " << s.max_us
+             << " }";
+         _results.push_back(out.str());
+
+         // Progress goes to stderr, so stdout stays valid JSON
+         std::cerr << name << ": " << s.median_us << "us median" << std::endl;
+      }
+
+      void write(std::ostream& out) const
+      {
+         out << "{\n  \"suite\": " << quote(_suite) << ",\n  \"results\": [\n";
+         for (std::size_t i = 0; i != _results.size(); ++i)
+            out << _results[i] << (i + 1 == _results.size() ? "\n" : ",\n");
+         out << "  ]\n}\n";
+      }
+
+      // Write to the file named by path, or to stdout if path is null
+      bool write(char const* path) const
+      {
+         if (!path)
+         {
+            write(std::cout);
+            return bool(std::cout);
+         }
+         std::ofstream file(path);
+         write(file);
+         return bool(file);
+      }
+
+   private:
+
+      std::string                _suite;
+      std::vector<std::string>   _results;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Command line
+   ////////////////////////////////////////////////////////////////////////////
+   struct options
+   {
+      bool           quick = false;
+      char const*    output = nullptr;    // Null for stdout
+   };
+
+   // Parse [--quick] [output.json]. Anything else goes to
+   // other(argc, argv, i) first, which returns false if it does not take
+   // argv[i], and may step i past the arguments it takes.
+   template <typename F>
+   options parse_options(int argc, char const* argv[], F other)
+   {
+      options opts;
+      for (int i = 1; i < argc; ++i)
+      {
+         if (std::strcmp(argv[i], "--quick") == 0)
+            opts.quick = true;
+         else if (!other(argc, argv, i))
+            opts.output = argv[i];
+      }
+      return opts;
+   }
+
+   inline options parse_options(int argc, char const* argv[])
+   {
+      return parse_options(argc, argv, [](int, char const*[], int&) { return false; });
+   }
+
+   // Write the report where the options say. Returns main's exit code.
+   inline int finish(report const& r, options const& opts)
+   {
+      if (r.write(opts.output))
+         return 0;
+      std::cerr << "Error. Cannot write "
+         << (opts.output ? opts.output : "to stdout") << std::endl;
+      return 1;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // An ARGB32 image surface and a canvas drawing into it. size is in
+   // canvas units, and scale is the device pixels per unit.
+   ////////////////////////////////////////////////////////////////////////////
+   struct image_surface
+   {
+      explicit image_surface(point size, float scale = 1)
+       : surface(make_surface(size, scale))
+       , cr(cairo_create(surface))
+       , cnv(*cr)
+      {}
+
+      ~image_surface()
+      {
+         cairo_destroy(cr);
+         cairo_surface_destroy(surface);
+      }
+
+      image_surface(image_surface const&) = delete;
+      image_surface& operator=(image_surface const&) = delete;
+
+      cairo_surface_t*  surface;
+      cairo_t*          cr;
+      canvas            cnv;
+
+   private:
+
+      // The device scale must be set before the cairo_t is made
+      static cairo_surface_t* make_surface(point size, float scale)
+      {
+         auto s = cairo_image_surface_create(
+            CAIRO_FORMAT_ARGB32, std::ceil(size.x * scale), std::ceil(size.y * scale));
+         cairo_surface_set_device_scale(s, scale, scale);
+         return s;
+      }
+   };
+}}}
+
+#endif
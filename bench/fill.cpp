@@ -0,0 +1,90 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include "bench.hpp"
+#include <photon/support/canvas.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+// photon_bench_fill: Measures rectangle fills into an image surface: opaque
+// and pixel aligned (the fast path), translucent, and unaligned, through
+// canvas::fill_rect and through a generic path fill, for a few sizes.
+//
+// Usage: photon_bench_fill [--quick] [output.json]
+//
+//    --quick: Fewer sizes
+//
+// The results go to output.json, or to stdout if no file is given.
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace cycfi::photon;
+using namespace cycfi::photon::bench;
+
+namespace
+{
+   constexpr point window_size = { 2560, 1440 };
+
+   struct fill_case
+   {
+      char const* name;
+      color       c;
+      float       offset;
+   };
+
+   fill_case const cases[] = {
+      { "opaque_aligned", rgba(40, 80, 120, 255), 0 },
+      { "translucent_aligned", rgba(40, 80, 120, 128), 0 },
+      { "opaque_unaligned", rgba(40, 80, 120, 255), 0.5 }
+   };
+}
+
+int main(int argc, char const* argv[])
+{
+   auto opts = parse_options(argc, argv);
+
+   std::vector<float> sizes = { 16, 256, 1440 };
+   if (!opts.quick)
+      sizes = { 4, 16, 64, 256, 1024, 1440 };
+
+   report r{ "photon_bench_fill" };
+   image_surface img{ window_size };
+   for (auto const& fc : cases)
+   {
+      for (auto size : sizes)
+      {
+         rect const box = { fc.offset, fc.offset, fc.offset + size, fc.offset + size };
+         auto params = std::vector<param>{ { "case", fc.name }, { "size", size } };
+         auto iterations = size < 256 ? 1000 : 100;
+
+         img.cnv.fill_style(fc.c);
+         r.add("fill_rect", params, measure(
+            [&]{ img.cnv.fill_rect(box); }, iterations
+         ));
+
+         r.add("path_fill", params, measure(
+            [&]
+            {
+               img.cnv.begin_path();
+               img.cnv.rect(box);
+               img.cnv.fill();
+            }, iterations
+         ));
+      }
+   }
+
+   // Clearing the whole window, as the host does on resize
+   img.cnv.fill_style(colors::black);
+   r.add("clear_fill_rect", {}, measure(
+      [&]{ img.cnv.fill_rect({ 0, 0, window_size.x, window_size.y }); }, 100
+   ));
+   r.add("clear_paint", {}, measure(
+      [&]
+      {
+         cairo_set_source_rgb(img.cr, 0, 0, 0);
+         cairo_paint(img.cr);
+      }, 100
+   ));
+
+   return finish(r, opts);
+}
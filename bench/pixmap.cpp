@@ -0,0 +1,109 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include "bench.hpp"
+#include <photon/support/pixmap.hpp>
+#include <cstring>
+#include <random>
+
+///////////////////////////////////////////////////////////////////////////////
+// photon_bench_pixmap: Measures the RGBA to premultiplied ARGB32 conversion
+// image loaders use, against a plain per byte swizzle, for opaque and
+// translucent images of a few sizes. Image files given in the command line
+// are also loaded and timed as a whole.
+//
+// Usage: photon_bench_pixmap [--quick] [--image file]... [output.json]
+//
+//    --quick: Fewer sizes
+//    --image: Also time loading this image file
+//
+// The results go to output.json, or to stdout if no file is given.
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace cycfi::photon;
+using namespace cycfi::photon::bench;
+
+namespace
+{
+   // The conversion as it used to be: a swizzle, without premultiplying
+   void swizzle_rgba(uint8_t const* src, uint32_t* dest_, std::size_t n)
+   {
+      auto dest = reinterpret_cast<uint8_t*>(dest_);
+      for (std::size_t x = 0; x != n; ++x)
+      {
+         dest[0] = src[2];
+         dest[1] = src[1];
+         dest[2] = src[0];
+         dest[3] = src[3];
+         src += 4;
+         dest += 4;
+      }
+   }
+
+   std::vector<uint8_t> make_image(std::size_t n, bool opaque)
+   {
+      std::mt19937 rng(7);
+      std::vector<uint8_t> data(n * 4);
+      for (auto& b : data)
+         b = rng();
+      if (opaque)
+      {
+         for (std::size_t i = 0; i != n; ++i)
+            data[i*4 + 3] = 255;
+      }
+      return data;
+   }
+}
+
+int main(int argc, char const* argv[])
+{
+   std::vector<char const*> images;
+   auto opts = parse_options(argc, argv,
+      [&](int argc, char const* argv[], int& i)
+      {
+         if (std::strcmp(argv[i], "--image") != 0 || i + 1 == argc)
+            return false;
+         images.push_back(argv[++i]);
+         return true;
+      }
+   );
+
+   std::vector<point> sizes = { { 256, 256 }, { 1920, 1080 } };
+   if (!opts.quick)
+      sizes = { { 64, 64 }, { 256, 256 }, { 1024, 768 }, { 1920, 1080 }, { 3840, 2160 } };
+
+   report r{ "photon_bench_pixmap" };
+   for (auto size : sizes)
+   {
+      auto n = std::size_t(size.x * size.y);
+      std::vector<uint32_t> dest(n);
+      auto iterations = n < 100000 ? 1000 : 100;
+
+      for (bool opaque : { true, false })
+      {
+         auto src = make_image(n, opaque);
+         auto params = std::vector<param>{
+            { "width", size.x }, { "height", size.y }
+          , { "alpha", opaque ? "opaque" : "translucent" }
+         };
+
+         r.add("premultiply_rgba", params, measure(
+            [&]{ premultiply_rgba(src.data(), dest.data(), n); }, iterations
+         ));
+         r.add("swizzle", params, measure(
+            [&]{ swizzle_rgba(src.data(), dest.data(), n); }, iterations
+         ));
+      }
+   }
+
+   for (auto path : images)
+   {
+      r.add("load", { { "file", path } }, measure(
+         [&]{ pixmap pm{ path }; }, 20, 2000
+      ));
+   }
+
+   return finish(r, opts);
+}
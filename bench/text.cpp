@@ -0,0 +1,231 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include "bench.hpp"
+#include <photon/view.hpp>
+#include <photon/element/text.hpp>
+#include <photon/support/glyphs.hpp>
+#include <cstring>
+#include <random>
+
+///////////////////////////////////////////////////////////////////////////////
+// photon_bench_text: Measures the text operations behind typing latency
+// and resize cost, for documents of 1KB to 10MB, in a few fonts. Nothing is
+// shown. Everything is drawn into an image surface.
+//
+// Usage: photon_bench_text [--quick] [output.json]
+//
+//    --quick: Stop at 100KB documents
+//
+// The results go to output.json, or to stdout if no file is given.
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace cycfi::photon;
+using namespace cycfi::photon::bench;
+
+namespace
+{
+   constexpr point   viewport_size = { 800, 600 };
+   constexpr float   box_width = 600;
+
+   char const* fonts[] = { "Open Sans", "Roboto", "Courier" };
+
+   std::size_t const doc_sizes[] = {
+      1024, 10 * 1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024
+   };
+
+   float const break_widths[] = { 200, 400, 800 };
+
+   // A reproducible document of about n bytes: paragraphs of made up
+   // sentences, with a few non-ASCII words thrown in.
+   std::string make_document(std::size_t n)
+   {
+      static char const* words[] = {
+         "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+         "photon", "glyph", "render", "canvas", "element", "layout",
+         "naïve", "café", "über", "façade", "résumé", "–", "“quoted”",
+         "supercalifragilisticexpialidocious", "a", "of", "in", "to"
+      };
+      constexpr auto num_words = sizeof(words) / sizeof(words[0]);
+
+      std::minstd_rand rand{ 1 };
+      std::string doc;
+      doc.reserve(n + 64);
+      std::size_t para = 0;
+      while (doc.size() < n)
+      {
+         doc += words[rand() % num_words];
+         if (doc.size() - para > 600 + rand() % 400)
+         {
+            doc += ".\n";
+            para = doc.size();
+         }
+         else
+         {
+            doc += ' ';
+         }
+      }
+      doc.resize(n);
+
+      // Do not leave a partial UTF-8 sequence at the end
+      while (!doc.empty() && (uint8_t(doc.back()) & 0x80))
+         doc.pop_back();
+      return doc;
+   }
+
+   // Exposes the caret mapping of basic_text_box
+   struct text_box : basic_text_box
+   {
+      using basic_text_box::basic_text_box;
+      using basic_text_box::caret_position;
+      using basic_text_box::glyph_info;
+   };
+
+   // An offscreen view and canvas to draw into
+   struct offscreen : image_surface
+   {
+      offscreen()
+       : image_surface(viewport_size)
+       , view_(nullptr)
+      {}
+
+      // Lay out the box for a viewport showing it from scroll_y down.
+      context layout(element& e, float scroll_y = 0)
+      {
+         context ctx{ view_, cnv, &e, { 0, 0, box_width, full_extent } };
+         e.layout(ctx);
+         auto height = e.limits(ctx).min.y;
+         ctx.bounds = { 0, -scroll_y, box_width, height - scroll_y };
+         view_.dirty({ 0, 0, viewport_size.x, viewport_size.y });
+         return ctx;
+      }
+
+      void clear()
+      {
+         cairo_save(cr);
+         cairo_set_source_rgb(cr, 1, 1, 1);
+         cairo_paint(cr);
+         cairo_restore(cr);
+      }
+
+      view              view_;
+   };
+
+   void bench_glyphs(report& r, std::string const& doc, char const* font)
+   {
+      auto first = doc.data();
+      auto last = first + doc.size();
+      auto params = std::vector<param>{ { "font", font }, { "doc_bytes", doc.size() } };
+
+      r.add("master_glyphs", params, measure(
+         [&]{ master_glyphs{ first, last, font, 14 }; }, 20
+      ));
+
+      master_glyphs master{ first, last, font, 14 };
+      r.add("master_glyphs_text", params, measure(
+         [&]{ master.text(first, last); }, 20
+      ));
+
+      for (auto width : break_widths)
+      {
+         auto p = params;
+         p.emplace_back("width", width);
+         std::vector<glyphs> rows;
+         r.add("break_lines", p, measure(
+            [&]{ rows.clear(); master.break_lines(width, rows); }, 20
+         ));
+      }
+   }
+
+   void bench_text_box(report& r, std::string const& doc, char const* font)
+   {
+      auto params = std::vector<param>{ { "font", font }, { "doc_bytes", doc.size() } };
+
+      offscreen off;
+      text_box box{ doc, font, 14 };
+
+      // Look at the middle of the document
+      auto height = off.layout(box).bounds.height();
+      auto scroll_y = std::max(0.0f, height / 2 - viewport_size.y / 2);
+      auto ctx = off.layout(box, scroll_y);
+
+      // Caret mapping of random spots in the viewport, and back
+      std::minstd_rand rand{ 1 };
+      std::vector<point> spots;
+      for (int i = 0; i != 256; ++i)
+         spots.push_back({ float(rand() % int(box_width)), float(rand() % int(viewport_size.y)) });
+
+      std::size_t i = 0;
+      r.add("caret_position", params, measure(
+         [&]{ box.caret_position(ctx, spots[i++ % spots.size()]); }, spots.size()
+      ));
+
+      std::vector<char const*> carets;
+      for (auto p : spots)
+         if (auto s = box.caret_position(ctx, p))
+            carets.push_back(s);
+      if (!carets.empty())
+      {
+         i = 0;
+         r.add("glyph_info", params, measure(
+            [&]{ box.glyph_info(ctx, carets[i++ % carets.size()]); }, carets.size()
+         ));
+      }
+
+      r.add("draw_viewport", params, measure(
+         [&]{ off.clear(); box.draw(ctx); cairo_surface_flush(off.surface); }, 100
+      ));
+
+      r.add("resize", params, measure(
+         [&, w = 0]() mutable
+         {
+            context c{ off.view_, off.cnv, &box, { 0, 0, box_width - (w++ % 2) * 50, full_extent } };
+            box.layout(c);
+         }, 20
+      ));
+
+      // Typing: insert a character where the caret is, then draw, the way
+      // it happens on each key press.
+      if (!carets.empty())
+      {
+         box.select_start(int(carets.front() - box.text().data()));
+         box.select_end(box.select_start());
+
+         char const* typed = "The quick brown fox jumps over the lazy dog. ";
+         auto len = std::strlen(typed);
+         i = 0;
+         r.add("typing", params, measure(
+            [&]
+            {
+               box.text(ctx, { uint32_t(typed[i++ % len]), 0 });
+               off.clear();
+               box.draw(ctx);
+               cairo_surface_flush(off.surface);
+            }, 100
+         ));
+      }
+   }
+}
+
+int main(int argc, char const* argv[])
+{
+   auto opts = parse_options(argc, argv);
+
+   report r{ "photon_bench_text" };
+   for (auto size : doc_sizes)
+   {
+      if (opts.quick && size > 100 * 1024)
+         break;
+
+      auto doc = make_document(size);
+      for (auto font : fonts)
+      {
+         bench_glyphs(r, doc, font);
+         bench_text_box(r, doc, font);
+      }
+   }
+
+   return finish(r, opts);
+}
@@ -0,0 +1,168 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include "bench.hpp"
+#include <photon/support/canvas.hpp>
+#include <photon/support/draw_utils.hpp>
+#include <photon/support/tile_renderer.hpp>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+// photon_bench_tiles: Measures full window repaints of a busy 2560x1440
+// panel (gradients, knobs, shadows and text), drawn directly into one
+// surface, and recorded then rasterized in tiles by 1 to N threads.
+// Nothing is shown. Everything is drawn into an image surface.
+//
+// Before timing, the tiled output is checked against the direct output,
+// pixel by pixel, at device scales 1 and 2. The benchmark fails if they
+// differ.
+//
+// Usage: photon_bench_tiles [--quick] [output.json]
+//
+//    --quick: Only 1 thread and all hardware threads
+//
+// The results go to output.json, or to stdout if no file is given.
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace cycfi::photon;
+using namespace cycfi::photon::bench;
+
+namespace
+{
+   constexpr point   window_size = { 2560, 1440 };
+   constexpr float   cell_size = 160;
+
+   // One panel of knobs, buttons and labels per cell
+   void draw_scene(canvas& cnv)
+   {
+      cnv.fill_style(rgba(35, 35, 37, 255));
+      cnv.fill_rect({ 0, 0, window_size.x, window_size.y });
+
+      for (float y = 0; y < window_size.y; y += cell_size)
+      {
+         for (float x = 0; x < window_size.x; x += cell_size)
+         {
+            rect cell = { x, y, x + cell_size, y + cell_size };
+            draw_panel(cnv, cell.inset(8, 8), rgba(28, 30, 34, 192));
+
+            auto cx = x + cell_size / 2;
+            draw_knob(cnv, { cx, y + 60, 36 }, rgba(80, 160, 220, 255));
+            draw_button(cnv, { x + 24, y + 110, x + cell_size - 24, y + 136 }, rgba(60, 60, 60, 255));
+
+            cnv.fill_style(colors::white);
+            cnv.font("Open Sans", 12);
+            cnv.text_align(canvas::center | canvas::middle);
+            cnv.fill_text({ cx, y + 123 }, "Frequency");
+         }
+      }
+   }
+
+   // The largest difference between the channels of a and b, and the
+   // number of pixels that differ
+   std::pair<int, std::size_t> compare(image_surface& a, image_surface& b)
+   {
+      cairo_surface_flush(a.surface);
+      cairo_surface_flush(b.surface);
+      auto stride = cairo_image_surface_get_stride(a.surface);
+      auto width = cairo_image_surface_get_width(a.surface);
+      auto height = cairo_image_surface_get_height(a.surface);
+      auto pa = cairo_image_surface_get_data(a.surface);
+      auto pb = cairo_image_surface_get_data(b.surface);
+
+      int max_diff = 0;
+      std::size_t num_diffs = 0;
+      for (int y = 0; y != height; ++y)
+      {
+         auto ra = pa + y * stride;
+         auto rb = pb + y * stride;
+         for (int x = 0; x != width * 4; x += 4)
+         {
+            int diff = 0;
+            for (int c = 0; c != 4; ++c)
+               diff = std::max(diff, std::abs(ra[x + c] - rb[x + c]));
+            if (diff)
+               ++num_diffs;
+            max_diff = std::max(max_diff, diff);
+         }
+      }
+      return { max_diff, num_diffs };
+   }
+
+   // Draw the scene directly and tiled at the given device scale. Returns
+   // false, after saying so, if they differ.
+   bool check_tiled(float scale)
+   {
+      rect const area = { 0, 0, window_size.x, window_size.y };
+      image_surface direct{ window_size, scale };
+      image_surface tiled{ window_size, scale };
+
+      draw_scene(direct.cnv);
+      tile_renderer{}.render(tiled.cnv, canvas::record(draw_scene, scale), area);
+
+      auto diff = compare(direct, tiled);
+      if (diff.first != 0)
+      {
+         std::cerr
+            << "Error. At scale " << scale
+            << ", tiled output differs from direct output in "
+            << diff.second << " pixels (by up to " << diff.first << ")"
+            << std::endl;
+         return false;
+      }
+      return true;
+   }
+}
+
+int main(int argc, char const* argv[])
+{
+   auto opts = parse_options(argc, argv);
+
+   report r{ "photon_bench_tiles" };
+   image_surface img{ window_size };
+   rect const area = { 0, 0, window_size.x, window_size.y };
+
+   // Tiled must look the same as direct, on standard and HiDPI displays
+   if (!check_tiled(1) || !check_tiled(2))
+      return 1;
+
+   r.add("direct", {}, measure(
+      [&]{ draw_scene(img.cnv); cairo_surface_flush(img.surface); }, 20
+   ));
+
+   r.add("record", {}, measure(
+      [&]{ canvas::record(draw_scene); }, 20
+   ));
+
+   std::size_t const hardware = std::max(1u, std::thread::hardware_concurrency());
+   std::vector<std::size_t> thread_counts = { 1 };
+   if (!opts.quick)
+   {
+      for (std::size_t n = 2; n < hardware; n *= 2)
+         thread_counts.push_back(n);
+   }
+   if (hardware > 1)
+      thread_counts.push_back(hardware);
+
+   for (auto n : thread_counts)
+   {
+      for (int tile_size : { 128, 256, 512 })
+      {
+         tile_renderer tiles{ n, tile_size };
+         auto params = std::vector<param>{ { "threads", n }, { "tile_size", tile_size } };
+
+         r.add("tiled", params, measure(
+            [&]
+            {
+               tiles.render(img.cnv, canvas::record(draw_scene), area);
+               cairo_surface_flush(img.surface);
+            }, 20
+         ));
+      }
+   }
+
+   return finish(r, opts);
+}
@@ -25,6 +25,11 @@ namespace cycfi { namespace photon
    {
    }
 
+   float base_view::scale() const
+   {
+      return 1;
+   }
+
    void base_view::refresh()
    {
    }
@@ -33,6 +38,10 @@ namespace cycfi { namespace photon
    {
    }
 
+   void base_view::request_idle()
+   {
+   }
+
    void base_view::limits(view_limits limits_, bool maintain_aspect)
    {
    }
@@ -51,6 +60,15 @@ namespace cycfi { namespace photon
    {
    }
 
+   void clipboard(char const* first, char const* last)
+   {
+   }
+
+   void request_clipboard(clipboard_function f)
+   {
+      f(clipboard());
+   }
+
    void set_cursor(cursor_type type)
    {
       switch (type)
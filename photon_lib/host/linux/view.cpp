@@ -4,6 +4,7 @@
    Distributed under the MIT License (https://opensource.org/licenses/MIT)
 =============================================================================*/
 #include "view_impl.hpp"
+#include <photon/support/canvas.hpp>
 #include <cairo.h>
 
 namespace cycfi { namespace photon
@@ -37,30 +38,53 @@ namespace cycfi { namespace photon
       void clear_surface(cairo_surface_t* surface)
       {
          cairo_t* cr = cairo_create(surface);
-         cairo_set_source_rgb(cr, 0, 0, 0); // $$$ fixme $$$
-         cairo_paint(cr);
+         {
+            // fill_rect takes the direct path for image surfaces
+            double left, top, right, bottom;
+            cairo_clip_extents(cr, &left, &top, &right, &bottom);
+            canvas cnv{ *cr };
+            cnv.fill_style(colors::black); // $$$ fixme $$$
+            cnv.fill_rect({ float(left), float(top), float(right), float(bottom) });
+         }
          cairo_destroy(cr);
       }
 
-      gboolean on_configure(GtkWidget* widget, GdkEventConfigure* event, gpointer user_data)
+      // The backing surface is an image surface at the monitor's scale:
+      // device pixels, with a device scale so that drawing is in points.
+      void make_surface(host_view* host_view)
       {
-         auto& main_view = get(user_data);
-         auto* host_view = platform_access::get_host_view(main_view);
          auto* window = host_view->window;
-
          if (host_view->surface)
             cairo_surface_destroy(host_view->surface);
 
-         host_view->surface = gdk_window_create_similar_surface(
-            gtk_widget_get_window(window), CAIRO_CONTENT_COLOR,
-            gtk_widget_get_allocated_width(window),
-            gtk_widget_get_allocated_height(window)
+         auto scale = gtk_widget_get_scale_factor(window);
+         host_view->surface = gdk_window_create_similar_image_surface(
+            gtk_widget_get_window(window), CAIRO_FORMAT_RGB24,
+            gtk_widget_get_allocated_width(window) * scale,
+            gtk_widget_get_allocated_height(window) * scale,
+            scale
          );
 
          clear_surface(host_view->surface);
+      }
+
+      gboolean on_configure(GtkWidget* widget, GdkEventConfigure* event, gpointer user_data)
+      {
+         auto& main_view = get(user_data);
+         make_surface(platform_access::get_host_view(main_view));
          return true;
       }
 
+      // The window moved to a monitor with another scale
+      void on_scale_factor(GObject* object, GParamSpec* pspec, gpointer user_data)
+      {
+         auto& main_view = get(user_data);
+         auto* host_view = platform_access::get_host_view(main_view);
+         if (gtk_widget_get_window(host_view->window))
+            make_surface(host_view);
+         main_view.refresh();
+      }
+
       gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data)
       {
          auto& main_view = get(user_data);
@@ -228,6 +252,23 @@ namespace cycfi { namespace photon
       );
    }
 
+   gboolean on_idle(gpointer user_data)
+   {
+      auto& main_view = get(user_data);
+      platform_access::get_host_view(main_view)->idle_source = 0;
+      main_view.idle();
+      return FALSE; // Once. Elements with work still pending ask again.
+   }
+
+   void on_destroy(GtkWidget* widget, gpointer user_data)
+   {
+      // The view must not be called after its widget is gone
+      auto* host_view = platform_access::get_host_view(get(user_data));
+      if (host_view->idle_source)
+         g_source_remove(host_view->idle_source);
+      host_view->idle_source = 0;
+   }
+
    void make_main_window(base_view& main_view, GtkWidget* window)
    {
       auto* drawing_area = gtk_drawing_area_new();
@@ -240,6 +281,9 @@ namespace cycfi { namespace photon
       g_signal_connect(G_OBJECT(drawing_area), "draw",
          G_CALLBACK(on_draw), &main_view);
 
+      g_signal_connect(G_OBJECT(drawing_area), "notify::scale-factor",
+         G_CALLBACK(on_scale_factor), &main_view);
+
       //gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER);
       gtk_window_set_default_size(GTK_WINDOW(window), 400, 300);
 
@@ -255,6 +299,8 @@ namespace cycfi { namespace photon
          G_CALLBACK(on_event_crossing), &main_view);
       g_signal_connect(drawing_area, "leave-notify-event",
          G_CALLBACK(on_event_crossing), &main_view);
+      g_signal_connect(drawing_area, "destroy",
+         G_CALLBACK(on_destroy), &main_view);
 
       // Ask to receive events the drawing area doesn't normally
       // subscribe to. In particular, we need to ask for the
@@ -288,6 +334,19 @@ namespace cycfi { namespace photon
        gtk_window_resize(GTK_WINDOW(h->window), p.x, p.y);
    }
 
+   void base_view::request_idle()
+   {
+      // Give the elements a chance to do some background work, about one
+      // display frame from now
+      if (!h->idle_source)
+         h->idle_source = g_timeout_add(16, on_idle, this);
+   }
+
+   float base_view::scale() const
+   {
+      return gtk_widget_get_scale_factor(h->window);
+   }
+
    void base_view::refresh()
    {
       auto x = gtk_widget_get_allocated_width(h->window);
@@ -320,11 +379,41 @@ namespace cycfi { namespace photon
 
    std::string clipboard()
    {
-      return "";
+      auto* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+      gchar* text = gtk_clipboard_wait_for_text(clip);
+      if (!text)
+         return {};
+      std::string result = text;
+      g_free(text);
+      return result;
    }
 
    void clipboard(std::string const& text)
    {
+      clipboard(text.data(), text.data() + text.size());
+   }
+
+   void clipboard(char const* first, char const* last)
+   {
+      auto* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+      gtk_clipboard_set_text(clip, first, gint(last - first));
+   }
+
+   namespace
+   {
+      void on_clipboard_text(GtkClipboard* clip, gchar const* text, gpointer user_data)
+      {
+         std::unique_ptr<clipboard_function> f{
+            static_cast<clipboard_function*>(user_data) };
+         (*f)(text ? std::string{ text } : std::string{});
+      }
+   }
+
+   void request_clipboard(clipboard_function f)
+   {
+      auto* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+      gtk_clipboard_request_text(
+         clip, on_clipboard_text, new clipboard_function(std::move(f)));
    }
 
    void set_cursor(cursor_type type)
@@ -46,6 +46,9 @@ namespace cycfi { namespace photon
       // Scroll acceleration tracking
       std::uint32_t scroll_time = 0;
 
+      // The pending idle call, if any
+      guint idle_source = 0;
+
       point cursor_position;
    };
 
@@ -130,6 +130,7 @@ namespace
    key_map                          _keys;
    bool                             _start;
    ph::base_view*                   _view;
+   NSTimer*                         _idle_timer;
 }
 @end
 
@@ -178,6 +179,34 @@ namespace
    //self.window.appearance = [NSAppearance appearanceNamed:NSAppearanceNameVibrantDark];
 }
 
+// Give the elements a chance to do some background work, about one display
+// frame from now. The timer fires once; elements with work still pending
+// ask again.
+- (void) request_idle
+{
+   if (_idle_timer)
+      return;
+   _idle_timer =
+      [NSTimer scheduledTimerWithTimeInterval : 1.0 / 60
+                                       target : self
+                                     selector : @selector(on_idle)
+                                     userInfo : nil
+                                      repeats : NO
+      ];
+}
+
+- (void) cancel_idle
+{
+   [_idle_timer invalidate];
+   _idle_timer = nil;
+}
+
+- (void) on_idle
+{
+   _idle_timer = nil;
+   _view->idle();
+}
+
 - (BOOL) canBecomeKeyView
 {
    return YES;
@@ -495,6 +524,8 @@ namespace cycfi { namespace photon
 
    base_view::~base_view()
    {
+      // The timer holds on to the view, which must not call us anymore
+      [get_mac_view(host()) cancel_idle];
    }
 
    point base_view::cursor_pos() const
@@ -522,6 +553,18 @@ namespace cycfi { namespace photon
       [[ns_view window] setFrame : frame display : YES animate : false];
    }
 
+   void base_view::request_idle()
+   {
+      [get_mac_view(host()) request_idle];
+   }
+
+   float base_view::scale() const
+   {
+      // Not in a window (yet): there is no backing store to scale to
+      auto window = [get_mac_view(host()) window];
+      return window ? [window backingScaleFactor] : 1;
+   }
+
    void base_view::refresh()
    {
       get_mac_view(host()).needsDisplay = true;
@@ -559,15 +602,28 @@ namespace cycfi { namespace photon
    }
 
    void clipboard(std::string const& text)
+   {
+      clipboard(text.data(), text.data() + text.size());
+   }
+
+   void clipboard(char const* first, char const* last)
    {
       NSArray* types = [NSArray arrayWithObjects:NSPasteboardTypeString, nil];
 
       NSPasteboard* pasteboard = [NSPasteboard generalPasteboard];
       [pasteboard declareTypes:types owner:nil];
-      [pasteboard setString:[NSString stringWithUTF8String:text.c_str()]
+      [pasteboard setString:[[NSString alloc] initWithBytes:first
+                                                     length:last - first
+                                                   encoding:NSUTF8StringEncoding]
                     forType:NSPasteboardTypeString];
    }
 
+   void request_clipboard(clipboard_function f)
+   {
+      // The pasteboard is read right away
+      f(clipboard());
+   }
+
    void set_cursor(cursor_type type)
    {
       switch (type)
@@ -9,10 +9,12 @@
 #include <photon/element/align.hpp>
 #include <photon/element/basic.hpp>
 #include <photon/element/button.hpp>
+#include <photon/element/cache.hpp>
 #include <photon/element/composite.hpp>
 #include <photon/element/dial.hpp>
 #include <photon/element/floating.hpp>
 #include <photon/element/flow.hpp>
+#include <photon/element/hit_area.hpp>
 #include <photon/element/image.hpp>
 #include <photon/element/layer.hpp>
 #include <photon/element/margin.hpp>
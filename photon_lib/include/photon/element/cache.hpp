@@ -0,0 +1,83 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_WIDGET_CACHE_MARCH_15_2019)
+#define CYCFI_PHOTON_GUI_LIB_WIDGET_CACHE_MARCH_15_2019
+
+#include <photon/element/proxy.hpp>
+#include <photon/support/canvas.hpp>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Draw caches
+   //
+   // draw_cache records the subject's drawing in a display list, then
+   // replays it for as long as the subject's inputs stay the same: the size
+   // of the bounds, the device scale and a generation that is bumped whenever the subject may
+   // have changed: when it is laid out, gets an event (mouse, keyboard or
+   // text), the focus or a value, when it or any element inside it is
+   // refreshed, or when its idle asks the view for a refresh (e.g. a
+   // blinking caret). Moving the bounds only moves the replay.
+   //
+   // Call invalidate() after changing the subject in other ways. Subjects
+   // that change on their own (e.g. animate in idle) are recorded again
+   // each time, so they are not good candidates.
+   ////////////////////////////////////////////////////////////////////////////
+   class draw_cache_base : public proxy_base
+   {
+   public:
+
+   // Image
+
+      virtual void            draw(context const& ctx);
+      virtual void            layout(context const& ctx);
+      virtual void            refresh(context const& ctx, element& element);
+      virtual bool            scroll(context const& ctx, point dir, point p);
+      virtual void            idle(basic_context const& ctx);
+
+      using element::refresh;
+
+   // Control
+
+      virtual element*        click(context const& ctx, mouse_button btn);
+      virtual void            drag(context const& ctx, mouse_button btn);
+      virtual bool            key(context const& ctx, key_info k);
+      virtual bool            text(context const& ctx, text_info info);
+      virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
+      virtual bool            focus(focus_request r);
+
+      using proxy_base::focus;
+
+   // Receiver
+
+      virtual void            value(bool val);
+      virtual void            value(int val);
+      virtual void            value(double val);
+      virtual void            value(std::string val);
+
+   // Cache
+
+      void                    invalidate() { ++_generation; }
+      bool                    is_cached(context const& ctx) const;
+
+   private:
+
+      canvas::display_list    _display_list;
+      rect                    _bounds;             // When recorded
+      float                   _scale = 1;          // When recorded
+      std::size_t             _recorded_generation = 0;
+      std::size_t             _generation = 0;
+   };
+
+   template <typename Subject>
+   inline proxy<typename std::decay<Subject>::type, draw_cache_base>
+   draw_cache(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
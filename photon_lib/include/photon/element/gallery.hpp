@@ -9,6 +9,7 @@
 #include <photon/support/theme.hpp>
 #include <photon/support/text_utils.hpp>
 #include <photon/element.hpp>
+#include <vector>
 
 namespace cycfi { namespace photon
 {
@@ -165,6 +166,7 @@ namespace cycfi { namespace photon
 
       float                   _major_divisions;
       float                   _minor_divisions;
+      std::vector<canvas::line> _lines;
    };
 
 
@@ -0,0 +1,58 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_HIT_AREA_MARCH_17_2019)
+#define CYCFI_PHOTON_GUI_LIB_HIT_AREA_MARCH_17_2019
+
+#include <photon/element/proxy.hpp>
+#include <photon/support/hit_shape.hpp>
+#include <functional>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Hit areas
+   //
+   // hit_area limits hit testing (and with it clicks and hovering) of the
+   // subject to a shape, given in local coordinates: (0, 0) is the top-left
+   // of the bounds. The shape may be fixed or computed from the local
+   // bounds by a function, in which case it is computed once per size.
+   ////////////////////////////////////////////////////////////////////////////
+   class hit_area_base : public proxy_base
+   {
+   public:
+
+      using shape_function = std::function<hit_shape(rect bounds)>;
+
+                              hit_area_base(hit_shape shape);
+                              hit_area_base(shape_function f);
+
+      virtual element*        hit_test(context const& ctx, point p);
+
+      hit_shape const&        shape(rect bounds);
+
+   private:
+
+      shape_function          _shape_f;
+      hit_shape               _shape;
+      point                   _size = { -1, -1 };
+   };
+
+   template <typename Subject>
+   inline proxy<typename std::decay<Subject>::type, hit_area_base>
+   hit_area(hit_shape shape, Subject&& subject)
+   {
+      return { std::forward<Subject>(subject), std::move(shape) };
+   }
+
+   template <typename Subject>
+   inline proxy<typename std::decay<Subject>::type, hit_area_base>
+   hit_area(hit_area_base::shape_function f, Subject&& subject)
+   {
+      return { std::forward<Subject>(subject), std::move(f) };
+   }
+}}
+
+#endif
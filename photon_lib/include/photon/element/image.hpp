@@ -9,31 +9,70 @@
 #include <photon/element/element.hpp>
 #include <photon/support/canvas.hpp>
 #include <photon/support/pixmap.hpp>
+#include <photon/support/async_pixmap.hpp>
+#include <functional>
 #include <memory>
 
 namespace cycfi { namespace photon
 {
    ////////////////////////////////////////////////////////////////////////////
    // Images
+   //
+   // Images made from an async_pixmap have their size (and limits) right
+   // away, but draw the placeholder color (transparent: nothing) until the
+   // pixmap is decoded. Drawing one moves it ahead of the images that are
+   // not visible yet. It refreshes itself when the pixels come in. If
+   // decoding fails, the image draws nothing from then on.
+   //
+   // Images drawn at other than their own size keep a copy resampled (with
+   // the best filter) to the size and device scale they are drawn at, so
+   // that they are simply copied to the canvas after the first time. The
+   // copy is made again when the size or scale changes.
    ////////////////////////////////////////////////////////////////////////////
    class image : public element
    {
    public:
                               image(char const* filename, float scale = 1);
                               image(pixmap_ptr pixmap_);
+                              image(async_pixmap_ptr pixmap_, color placeholder = {});
 
       point                   size() const;
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual void            idle(basic_context const& ctx);
       virtual rect            source_rect(context const& ctx) const;
 
    protected:
 
+      using draw_function = std::function<void(canvas& cnv, rect bounds)>;
+
+                              // The ways the pixmap is drawn into
+                              // prescaled copies
+      enum prescale_kind { prescale_whole, prescale_gizmo, prescale_hgizmo, prescale_vgizmo };
+
       photon::pixmap&         pixmap() const  { return *_pixmap.get(); }
 
+                              // A pixmap of the given size, drawn by f at
+                              // the device scale of ctx.canvas. Copies are
+                              // shared with other images of the same pixmap
+                              // through the pixmap registry; f must draw
+                              // the same thing for the same kind and size.
+      photon::pixmap const&   prescaled(
+                                 context const& ctx, prescale_kind kind
+                               , point size, draw_function f
+                              );
+
    private:
 
+      bool                    is_loading();
+
       pixmap_ptr              _pixmap;
+      async_pixmap_ptr        _async;
+      bool                    _failed = false;
+      color                   _placeholder;
+      pixmap_ptr              _prescaled;
+      point                   _prescaled_size;
+      float                   _prescaled_scale = 0;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -7,8 +7,12 @@
 #define CYCFI_PHOTON_GUI_LIB_WIDGET_TEXT_APRIL_17_2016
 
 #include <photon/support/glyphs.hpp>
+#include <photon/support/text_loader.hpp>
+#include <photon/support/shaping_pool.hpp>
 #include <photon/support/theme.hpp>
 #include <photon/element/element.hpp>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,23 +32,44 @@ namespace cycfi { namespace photon
                                , int style         = canvas::normal
                               );
 
+                              // Take text shaped ahead of time (see shaping_pool)
+                              static_text_box(
+                                 shaped_text&& text
+                               , color color_      = get_theme().text_box_font_color
+                              );
+
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
       virtual void            draw(context const& ctx);
+      virtual void            idle(basic_context const& ctx);
 
       std::string const&      text() const                     { return _text; }
       void                    text(std::string const& text);
       virtual void            value(std::string val);
 
+                              // Load the file at path in the background. Rows
+                              // are shown as they become ready.
+      virtual void            load(char const* path);
+      bool                    is_loading() const               { return bool(_loader); }
+
       using element::text;
 
    protected:
 
+      using text_loader_ptr = std::unique_ptr<text_loader>;
+      using text_blocks = std::vector<text_loader::block_ptr>;
+
+      void                    add_rows(text_loader::block& block, float width);
+      bool                    splice_rows(float width);
+
       std::string             _text;
       master_glyphs           _layout;
       std::vector<glyphs>     _rows;
       color                   _color;
       point                   _current_size = { -1, -1 };
+      text_loader_ptr         _loader;
+      text_blocks             _blocks;
+      std::size_t             _layout_count = 0;   // Bumped when _rows change
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -57,9 +82,13 @@ namespace cycfi { namespace photon
                                  std::string const& text
                                , char const* face  = get_theme().text_box_font
                                , float size        = get_theme().text_box_font_size
+                               , int style         = canvas::normal
                               );
 
+                              basic_text_box(shaped_text&& text);
+
       virtual void            draw(context const& ctx);
+      virtual void            idle(basic_context const& ctx);
       virtual element*        click(context const& ctx, mouse_button btn);
       virtual void            drag(context const& ctx, mouse_button btn);
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
@@ -67,6 +96,7 @@ namespace cycfi { namespace photon
       virtual bool            key(context const& ctx, key_info k);
       virtual bool            focus(focus_request r);
       virtual bool            is_control() const;
+      virtual void            load(char const* path);
 
       using element::focus;
       using static_text_box::text;
@@ -83,12 +113,15 @@ namespace cycfi { namespace photon
       virtual bool            word_break(char const* utf8) const;
       virtual bool            line_break(char const* utf8) const;
 
+                              // Pasted text is inserted once it arrives
+                              // and is shaped (see paste). Until then, the
+                              // text cannot be edited.
+      bool                    is_pasting() const      { return bool(_paste); }
+
    protected:
 
       void                    scroll_into_view(context const& ctx, bool save_x);
 
-   private:
-
       struct glyph_metrics
       {
          char const* str;           // The start of the utf8 string
@@ -100,14 +133,48 @@ namespace cycfi { namespace photon
       char const*             caret_position(context const& ctx, point p);
       glyph_metrics           glyph_info(context const& ctx, char const* s);
 
+   private:
+
+      bool                    scroll_caret_into_view(context const& ctx, bool save_x);
+      rect                    selection_bounds(context const& ctx);
+
       virtual void            delete_();
       virtual void            cut(view& v, int start, int end);
       virtual void            copy(view& v, int start, int end);
       virtual void            paste(view& v, int start, int end);
 
+                              // Trim pasted text, once it arrives, to what
+                              // the box accepts. Nothing is pasted if it
+                              // comes out empty.
+      virtual void            filter_paste(std::string& text) const;
+
       struct state_saver;
       using state_saver_f = std::function<void()>;
 
+      struct edit_damage;
+      struct paste_state;
+      using paste_state_ptr = std::shared_ptr<paste_state>;
+
+      // The caret and selection, relative to the top-left of the box. Made
+      // only when the selection or the layout changes.
+      struct selection_geometry
+      {
+         int                  select_start = -1;   // What it was made for
+         int                  select_end = -1;
+         std::size_t          layout_count = 0;
+         float                width = -1;
+
+         bool                 has_caret = false;
+         rect                 caret;
+         bool                 has_selection = false;
+         rect                 first_row;           // The selection in the
+         rect                 last_row;            // first and last row
+      };
+
+      using clock = std::chrono::steady_clock;
+
+      selection_geometry const& geometry(context const& ctx);
+      bool                    is_geometry_current() const;
       state_saver_f           capture_state();
 
       int                     _select_start;
@@ -115,6 +182,11 @@ namespace cycfi { namespace photon
       float                   _current_x;
       state_saver_f           _typing_state;
       bool                    _is_focus;
+      paste_state_ptr         _paste;
+      selection_geometry      _geometry;
+      point                   _origin;             // Where we were drawn last
+      bool                    _caret_visible = true;
+      clock::time_point       _caret_time;         // Last caret blink
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -139,7 +211,7 @@ namespace cycfi { namespace photon
 
    private:
 
-      virtual void            paste(view& v, int start, int end);
+      virtual void            filter_paste(std::string& text) const;
 
       std::string             _placeholder;
    };
@@ -306,14 +306,21 @@ namespace cycfi { namespace photon
       virtual void   key(key_info const& k) {}
       virtual void   text(text_info const& info) {}
       virtual void   focus(focus_request r) {}
+      virtual void   idle() {}
 
       void           refresh();
       void           refresh(rect area);
       void           limits(view_limits limits_);
 
+                     // Call idle() once, soon. Idle is not polled
+                     // otherwise: ask again from idle() while there is
+                     // background work pending.
+      void           request_idle();
+
       point          cursor_pos() const;
       point          size() const;
       void           size(point p);
+      float          scale() const;  // Device pixels per point
       bool           is_focus() const;
       host_view      host() const { return _view; }
 
@@ -368,9 +375,16 @@ namespace cycfi { namespace photon
    // extern std::function<std::unique_ptr<base_view>(host_view* h)> new_view;
 
    ////////////////////////////////////////////////////////////////////////////
-   // The clipboard
+   // The clipboard. Getting its text may wait for the application that owns
+   // it; the UI prefers request_clipboard.
    std::string clipboard();
    void clipboard(std::string const& text);
+   void clipboard(char const* first, char const* last);
+
+   // Get the clipboard text without waiting for it. f is called with the
+   // text, on the UI thread, when it arrives (possibly right away).
+   using clipboard_function = std::function<void(std::string text)>;
+   void request_clipboard(clipboard_function f);
 
    ////////////////////////////////////////////////////////////////////////////
    // The Cursor
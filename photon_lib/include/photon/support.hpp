@@ -19,6 +19,8 @@
 #include <photon/support/point.hpp>
 #include <photon/support/rect.hpp>
 #include <photon/support/draw_utils.hpp>
+#include <photon/support/shaping_pool.hpp>
+#include <photon/support/text_loader.hpp>
 #include <photon/support/text_utils.hpp>
 #include <photon/support/theme.hpp>
 
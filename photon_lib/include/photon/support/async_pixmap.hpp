@@ -0,0 +1,46 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_ASYNC_PIXMAP_MARCH_18_2019)
+#define CYCFI_PHOTON_GUI_LIB_ASYNC_PIXMAP_MARCH_18_2019
+
+#include <photon/support/pixmap.hpp>
+#include <memory>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // async_pixmap: A pixmap decoded on a shared set of worker threads. The
+   // size is read from the file header up front, so it is known right
+   // away. Images are decoded in the order they are created, except for
+   // those that are prioritized (e.g. when they are first drawn), which
+   // go ahead of the rest.
+   //
+   // The pixmap is dropped if the async_pixmap is destroyed before it is
+   // decoded.
+   ////////////////////////////////////////////////////////////////////////////
+   class async_pixmap
+   {
+   public:
+
+      explicit          async_pixmap(char const* filename, float scale = 1);
+
+      photon::size      size() const   { return _size; }
+      bool              ready() const;    // Decoded, or failed to
+      pixmap_ptr        get() const;      // Null until ready, or if it failed
+      void              prioritize();
+
+      struct state;
+
+   private:
+
+      photon::size      _size;
+      std::shared_ptr<state> _state;
+   };
+
+   using async_pixmap_ptr = std::shared_ptr<async_pixmap>;
+}}
+
+#endif
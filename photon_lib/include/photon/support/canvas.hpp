@@ -11,9 +11,10 @@
 #include <photon/support/circle.hpp>
 #include <photon/support/pixmap.hpp>
 
+#include <array>
 #include <vector>
 #include <functional>
-#include <stack>
+#include <memory>
 #include <cmath>
 #include <cassert>
 #include <cairo.h>
@@ -49,6 +50,7 @@ namespace cycfi { namespace photon
       void              scale(point p);
       point             device_to_user(point p);
       point             user_to_device(point p);
+      float             device_scale() const;   // Pixels per user space unit
 
       ///////////////////////////////////////////////////////////////////////////////////
       // Paths
@@ -74,6 +76,65 @@ namespace cycfi { namespace photon
       void              round_rect(photon::rect r, float radius);
       void              circle(photon::circle c);
 
+      ///////////////////////////////////////////////////////////////////////////////////
+      // Recorded paths: Record a path once, then add, fill, stroke or hit
+      // test it as often as needed, moved by an offset. Copies are cheap and
+      // share the recording.
+      class path
+      {
+      public:
+                        path() = default;
+         bool           empty() const { return !_path; }
+
+      private:
+
+         friend class canvas;
+         explicit       path(cairo_path_t* p);
+
+         std::shared_ptr<cairo_path_t> _path;
+      };
+
+                        // Record the path made by f(canvas&). The current
+                        // path is left as it was.
+                        template <typename F>
+      path              record_path(F f);
+
+      void              add_path(path const& p, point offset = {});
+      void              fill(path const& p, point offset = {});
+      void              stroke(path const& p, point offset = {});
+      bool              hit_test(path const& p, point pt, point offset = {});
+
+      ///////////////////////////////////////////////////////////////////////////////////
+      // Display lists: Drawing commands recorded once and replayed as often
+      // as needed, moved by an offset. Replays are vector exact at any
+      // transform.
+      class display_list
+      {
+      public:
+                        display_list() = default;
+         bool           empty() const { return !_surface; }
+
+                        // A recording of its own, with the same commands,
+                        // that another thread may replay.
+         display_list   copy() const;
+
+      private:
+
+         friend class canvas;
+         explicit       display_list(cairo_surface_t* s);
+
+         std::shared_ptr<cairo_surface_t> _surface;
+      };
+
+                        // Record what f(canvas&) draws, on a canvas of its
+                        // own, with no bounds and no clip. scale is the
+                        // device scale of the canvas it will be replayed
+                        // on, for drawing that depends on it.
+                        template <typename F>
+      static display_list record(F f, float scale = 1);
+
+      void              replay(display_list const& dl, point offset = {});
+
       ///////////////////////////////////////////////////////////////////////////////////
       // Styles
       void              fill_style(color c);
@@ -82,30 +143,57 @@ namespace cycfi { namespace photon
 
       ///////////////////////////////////////////////////////////////////////////////////
       // Gradients
+      //
+      // A gradient makes its cairo pattern the first time it is drawn and
+      // keeps it, so drawing it again costs nothing. The geometry is fixed
+      // at construction; add_color_stop lets the pattern go. Gradients
+      // with the same geometry and color stops share their pattern.
       struct color_stop
       {
          float          offset;
          photon::color  color;
       };
 
-      struct linear_gradient
+      class linear_gradient
       {
-         point start;
-         point end;
+      public:
+                  linear_gradient(point start, point end);
+
+         void     add_color_stop(color_stop cs);
+
+         point const start;
+         point const end;
+
+      private:
+
+         friend class canvas;
 
-         void  add_color_stop(color_stop cs);
-         std::vector<color_stop> space;
+         std::vector<color_stop>                   _space;
+         mutable std::shared_ptr<cairo_pattern_t>  _pattern;
       };
 
-      struct radial_gradient
+      class radial_gradient
       {
-         point c1;
-         float c1_radius;
-         point c2 = c1;
-         float c2_radius = c1_radius;
+      public:
+                  radial_gradient(point c1, float c1_radius);
+                  radial_gradient(
+                     point c1, float c1_radius
+                   , point c2, float c2_radius
+                  );
+
+         void     add_color_stop(color_stop cs);
+
+         point const c1;
+         float const c1_radius;
+         point const c2;
+         float const c2_radius;
+
+      private:
 
-         void  add_color_stop(color_stop cs);
-         std::vector<color_stop> space;
+         friend class canvas;
+
+         std::vector<color_stop>                   _space;
+         mutable std::shared_ptr<cairo_pattern_t>  _pattern;
       };
 
       void              fill_style(linear_gradient const& gr);
@@ -126,13 +214,27 @@ namespace cycfi { namespace photon
       void              stroke_rect(photon::rect r);
       void              stroke_round_rect(photon::rect r, float radius);
 
+      ///////////////////////////////////////////////////////////////////////////////////
+      // Batches: One path and one stroke or fill for the whole batch. Axis
+      // aligned lines are snapped to the pixel grid.
+      struct line
+      {
+         point from;
+         point to;
+      };
+
+      void              stroke_lines(line const* first, line const* last);
+      void              fill_rects(photon::rect const* first, photon::rect const* last);
+      void              stroke_polyline(point const* first, point const* last);
+
       ///////////////////////////////////////////////////////////////////////////////////
       // Font
       enum font_style
       {
-         normal   = 0,
-         bold     = 1,
-         italic   = 2
+         normal    = 0,
+         bold      = 1,
+         italic    = 2,
+         monospace = 4    // Layout hint only: ASCII on a fixed grid
       };
 
       void              font(char const* face, float size = 16, int style = normal);
@@ -202,20 +304,53 @@ namespace cycfi { namespace photon
       friend struct blur;
       friend struct fill_blur;
 
+      using pattern_ptr = std::shared_ptr<cairo_pattern_t>;
+
+      static pattern_ptr pattern(linear_gradient const& gr);
+      static pattern_ptr pattern(radial_gradient const& gr);
+
+      // A fill or stroke style: a solid color or a cairo pattern (e.g. a
+      // gradient). Copying one does not allocate.
+      struct style
+      {
+         enum kind_enum { none, solid, pattern };
+
+         kind_enum               kind           = none;
+         color                   solid_color;
+         pattern_ptr             pattern_;
+      };
+
+      void              apply(style const& s);
       void              apply_fill_style();
       void              apply_stroke_style();
 
       struct canvas_state
       {
-         std::function<void()>   stroke_style;
-         std::function<void()>   fill_style;
+         style                   stroke_style;
+         style                   fill_style;
          int                     align          = 0;
 
          enum pattern_state { none_set, stroke_set, fill_set };
          pattern_state           pattern_set = none_set;
       };
 
-      using state_stack = std::stack<canvas_state>;
+      // Saved states. The first few are kept inline, so save and restore
+      // do not allocate unless states are nested very deep.
+      class state_stack
+      {
+      public:
+
+         void                    push(canvas_state const& s);
+         void                    pop(canvas_state& s);
+
+      private:
+
+         static constexpr std::size_t inline_size = 16;
+
+         std::array<canvas_state, inline_size>  _inline;
+         std::vector<canvas_state>              _spill;
+         std::size_t                            _size = 0;
+      };
 
       cairo_t&          _context;
       canvas_state      _state;
@@ -18,8 +18,122 @@
 # include FT_TYPE1_TABLES_H
 #endif
 
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <list>
+#include <map>
+
 namespace cycfi { namespace photon
 {
+   namespace detail
+   {
+      ////////////////////////////////////////////////////////////////////////
+      // pattern_cache: Gradient patterns, keyed by their geometry and color
+      // stops. Widgets draw the same gradients frame after frame, so each
+      // pattern is made once and reused. When the cache is full, the least
+      // recently used pattern is let go. Each thread has its own cache.
+      //
+      // Keys are fixed size, so looking one up does not allocate. Gradients
+      // with more than max_stops color stops are not cached.
+      ////////////////////////////////////////////////////////////////////////
+      class pattern_cache
+      {
+      public:
+
+         static constexpr std::size_t max_geometry = 6;
+         static constexpr std::size_t max_stops = 8;
+
+         // The gradient kind, its geometry, the number of stops and the
+         // stops (offset and color)
+         using key_type = std::array<float, 2 + max_geometry + max_stops * 5>;
+         using pattern_ptr = std::shared_ptr<cairo_pattern_t>;
+
+         static constexpr std::size_t capacity = 256;
+
+         template <typename Make>
+         pattern_ptr get(key_type const& key, Make make)
+         {
+            auto i = _index.find(key);
+            if (i != _index.end())
+            {
+               _lru.splice(_lru.begin(), _lru, i->second);
+               return i->second->second;
+            }
+
+            auto pat = pattern_ptr{ make(), cairo_pattern_destroy };
+            _lru.emplace_front(key, pat);
+            _index.emplace(key, _lru.begin());
+            if (_lru.size() > capacity)
+            {
+               _index.erase(_lru.back().first);
+               _lru.pop_back();
+            }
+            return pat;
+         }
+
+      private:
+
+         using entry = std::pair<key_type, pattern_ptr>;
+         using entry_list = std::list<entry>;
+
+         entry_list                             _lru;
+         std::map<key_type, entry_list::iterator> _index;
+      };
+
+      inline pattern_cache& patterns()
+      {
+         thread_local pattern_cache cache;
+         return cache;
+      }
+
+      // Returns false if the gradient has too many stops to be cached
+      inline bool make_key(
+         pattern_cache::key_type& key, float kind
+       , std::initializer_list<float> geometry
+       , std::vector<canvas::color_stop> const& space)
+      {
+         if (space.size() > pattern_cache::max_stops)
+            return false;
+
+         key.fill(0);
+         auto i = key.begin();
+         *i++ = kind;
+         std::copy(geometry.begin(), geometry.end(), i);
+         i += pattern_cache::max_geometry;
+         *i++ = space.size();
+         for (auto cs : space)
+         {
+            for (float f : { cs.offset, cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha })
+               *i++ = f;
+         }
+         return true;
+      }
+
+      template <typename Make>
+      inline pattern_cache::pattern_ptr get_pattern(
+         float kind, std::initializer_list<float> geometry
+       , std::vector<canvas::color_stop> const& space, Make make)
+      {
+         pattern_cache::key_type key;
+         if (make_key(key, kind, geometry, space))
+            return patterns().get(key, make);
+         return { make(), cairo_pattern_destroy };
+      }
+
+      inline void add_color_stops(
+         cairo_pattern_t* pat, std::vector<canvas::color_stop> const& space)
+      {
+         for (auto cs : space)
+         {
+            cairo_pattern_add_color_stop_rgba(
+               pat, cs.offset,
+               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
+            );
+         }
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Inlines
    ////////////////////////////////////////////////////////////////////////////
@@ -51,6 +165,15 @@ namespace cycfi { namespace photon
       cairo_scale(&_context, p.x, p.y);
    }
 
+   inline float canvas::device_scale() const
+   {
+      double dx = 1, dy = 0;
+      cairo_user_to_device_distance(&_context, &dx, &dy);
+      double sx = 1, sy = 1;
+      cairo_surface_get_device_scale(cairo_get_target(&_context), &sx, &sy);
+      return std::hypot(dx, dy) * sx;
+   }
+
    inline point canvas::device_to_user(point p)
    {
       double x = p.x;
@@ -171,22 +294,120 @@ namespace cycfi { namespace photon
       arc(point{ c.cx, c.cy }, c.radius, 0.0, 2 * M_PI);
    }
 
-   inline void canvas::fill_style(color c)
+   inline canvas::path::path(cairo_path_t* p)
+    : _path(p, cairo_path_destroy)
+   {}
+
+   template <typename F>
+   inline canvas::path canvas::record_path(F f)
    {
-      _state.fill_style = [this, c]()
-      {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
+      auto saved = cairo_copy_path(&_context);
+      cairo_new_path(&_context);
+      f(*this);
+      path r{ cairo_copy_path(&_context) };
+      cairo_new_path(&_context);
+      cairo_append_path(&_context, saved);
+      cairo_path_destroy(saved);
+      return r;
+   }
+
+   inline canvas::display_list::display_list(cairo_surface_t* s)
+    : _surface(s, cairo_surface_destroy)
+   {}
+
+   inline canvas::display_list canvas::display_list::copy() const
+   {
+      if (empty())
+         return {};
+
+      double scale_x, scale_y;
+      cairo_surface_get_device_scale(_surface.get(), &scale_x, &scale_y);
+      return record([this](canvas& cnv) { cnv.replay(*this); }, scale_x);
+   }
+
+   template <typename F>
+   inline canvas::display_list canvas::record(F f, float scale)
+   {
+      display_list dl{
+         cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr)
       };
+      cairo_surface_set_device_scale(dl._surface.get(), scale, scale);
+      auto context = cairo_create(dl._surface.get());
+      {
+         canvas cnv{ *context };
+         f(cnv);
+      }
+      cairo_destroy(context);
+      return dl;
+   }
+
+   inline void canvas::replay(display_list const& dl, point offset)
+   {
+      if (dl.empty())
+         return;
+
+      // Replayed into another recording, cairo keeps a snapshot of dl, one
+      // shared by all recordings unless dl is flushed. Give each its own,
+      // so that they may be replayed on different threads.
+      cairo_surface_flush(dl._surface.get());
+
+      auto state = new_state();
+      cairo_set_source_surface(&_context, dl._surface.get(), offset.x, offset.y);
+      cairo_paint(&_context);
+   }
+
+   inline void canvas::add_path(path const& p, point offset)
+   {
+      if (p.empty())
+         return;
+
+      cairo_matrix_t m;
+      cairo_get_matrix(&_context, &m);
+      cairo_translate(&_context, offset.x, offset.y);
+      cairo_append_path(&_context, p._path.get());
+      cairo_set_matrix(&_context, &m);
+   }
+
+   inline void canvas::fill(path const& p, point offset)
+   {
+      begin_path();
+      add_path(p, offset);
+      fill();
+   }
+
+   inline void canvas::stroke(path const& p, point offset)
+   {
+      begin_path();
+      add_path(p, offset);
+      stroke();
+   }
+
+   inline bool canvas::hit_test(path const& p, point pt, point offset)
+   {
+      auto saved = cairo_copy_path(&_context);
+      cairo_new_path(&_context);
+      add_path(p, offset);
+      bool hit = cairo_in_fill(&_context, pt.x, pt.y);
+      cairo_new_path(&_context);
+      cairo_append_path(&_context, saved);
+      cairo_path_destroy(saved);
+      return hit;
+   }
+
+   inline void canvas::fill_style(color c)
+   {
+      _state.fill_style.kind = style::solid;
+      _state.fill_style.solid_color = c;
+      _state.fill_style.pattern_.reset();
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
 
    inline void canvas::stroke_style(color c)
    {
-      _state.stroke_style = [this, c]()
-      {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
-      };
+      _state.stroke_style.kind = style::solid;
+      _state.stroke_style.solid_color = c;
+      _state.stroke_style.pattern_.reset();
       if (_state.pattern_set == _state.stroke_set)
          _state.pattern_set = _state.none_set;
    }
@@ -196,47 +417,59 @@ namespace cycfi { namespace photon
       cairo_set_line_width(&_context, w);
    }
 
-   inline void canvas::fill_style(linear_gradient const& gr)
+   inline canvas::pattern_ptr canvas::pattern(linear_gradient const& gr)
    {
-      _state.fill_style = [this, gr]()
+      if (!gr._pattern)
       {
-         cairo_pattern_t* pat =
-            cairo_pattern_create_linear(
-               gr.start.x, gr.start.y, gr.end.x, gr.end.y
-            );
+         gr._pattern = detail::get_pattern(
+            0, { gr.start.x, gr.start.y, gr.end.x, gr.end.y }, gr._space,
+            [&gr]()
+            {
+               cairo_pattern_t* pat =
+                  cairo_pattern_create_linear(
+                     gr.start.x, gr.start.y, gr.end.x, gr.end.y
+                  );
+               detail::add_color_stops(pat, gr._space);
+               return pat;
+            }
+         );
+      }
+      return gr._pattern;
+   }
 
-         for (auto cs : gr.space)
-         {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
-            );
-         }
-         cairo_set_source(&_context, pat);
-      };
+   inline canvas::pattern_ptr canvas::pattern(radial_gradient const& gr)
+   {
+      if (!gr._pattern)
+      {
+         gr._pattern = detail::get_pattern(
+            1, { gr.c1.x, gr.c1.y, gr.c1_radius, gr.c2.x, gr.c2.y, gr.c2_radius }, gr._space,
+            [&gr]()
+            {
+               cairo_pattern_t* pat =
+                  cairo_pattern_create_radial(
+                     gr.c1.x, gr.c1.y, gr.c1_radius,
+                     gr.c2.x, gr.c2.y, gr.c2_radius
+                  );
+               detail::add_color_stops(pat, gr._space);
+               return pat;
+            }
+         );
+      }
+      return gr._pattern;
+   }
+
+   inline void canvas::fill_style(linear_gradient const& gr)
+   {
+      _state.fill_style.kind = style::pattern;
+      _state.fill_style.pattern_ = pattern(gr);
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
 
    inline void canvas::fill_style(radial_gradient const& gr)
    {
-      _state.fill_style = [this, gr]()
-      {
-         cairo_pattern_t* pat =
-            cairo_pattern_create_radial(
-               gr.c1.x, gr.c1.y, gr.c1_radius,
-               gr.c2.x, gr.c2.y, gr.c2_radius
-            );
-
-         for (auto cs : gr.space)
-         {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
-            );
-         }
-         cairo_set_source(&_context, pat);
-      };
+      _state.fill_style.kind = style::pattern;
+      _state.fill_style.pattern_ = pattern(gr);
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
@@ -247,20 +480,207 @@ namespace cycfi { namespace photon
          &_context, rule == fill_winding ? CAIRO_FILL_RULE_WINDING : CAIRO_FILL_RULE_EVEN_ODD);
    }
 
+   inline canvas::linear_gradient::linear_gradient(point start, point end)
+    : start(start)
+    , end(end)
+   {}
+
    inline void canvas::linear_gradient::add_color_stop(color_stop cs)
    {
-      space.push_back(cs);
+      _space.push_back(cs);
+      _pattern.reset();
    }
 
+   inline canvas::radial_gradient::radial_gradient(point c1, float c1_radius)
+    : radial_gradient(c1, c1_radius, c1, c1_radius)
+   {}
+
+   inline canvas::radial_gradient::radial_gradient(
+      point c1, float c1_radius
+    , point c2, float c2_radius
+   )
+    : c1(c1)
+    , c1_radius(c1_radius)
+    , c2(c2)
+    , c2_radius(c2_radius)
+   {}
+
    inline void canvas::radial_gradient::add_color_stop(color_stop cs)
    {
-      space.push_back(cs);
+      _space.push_back(cs);
+      _pattern.reset();
+   }
+
+   namespace detail
+   {
+      // Map a user space point to the pixels of the surface, returning
+      // false if it does not fall on a pixel boundary.
+      inline bool to_pixels(cairo_t& context, double x, double y, long& px, long& py)
+      {
+         auto target = cairo_get_target(&context);
+         double sx, sy, ox, oy;
+         cairo_surface_get_device_scale(target, &sx, &sy);
+         cairo_surface_get_device_offset(target, &ox, &oy);
+         cairo_user_to_device(&context, &x, &y);
+         x = x * sx + ox;
+         y = y * sy + oy;
+         px = std::lround(x);
+         py = std::lround(y);
+         return std::abs(x - px) < 1e-3 && std::abs(y - py) < 1e-3;
+      }
+
+      // True if r covers whole pixels under an axis aligned transform
+      inline bool is_pixel_aligned(cairo_t& context, rect r)
+      {
+         cairo_matrix_t m;
+         cairo_get_matrix(&context, &m);
+         if (m.xy != 0 || m.yx != 0)
+            return false;
+
+         long l, t, r_, b;
+         return to_pixels(context, r.left, r.top, l, t)
+            && to_pixels(context, r.right, r.bottom, r_, b);
+      }
+
+      // Fill r with an opaque color straight into the memory of an image
+      // surface, one row at a time. This is done only when r, cut by the
+      // clip, falls on whole pixels and the clip is made of rectangles.
+      // Returns false, with nothing drawn, otherwise.
+      inline bool fill_rect_direct(cairo_t& context, rect r, color c)
+      {
+         auto target = cairo_get_target(&context);
+         if (cairo_get_group_target(&context) != target
+            || cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE)
+            return false;
+
+         auto format = cairo_image_surface_get_format(target);
+         auto op = cairo_get_operator(&context);
+         if ((format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24)
+            || (op != CAIRO_OPERATOR_OVER && op != CAIRO_OPERATOR_SOURCE))
+            return false;
+
+         cairo_matrix_t m;
+         cairo_get_matrix(&context, &m);
+         if (m.xy != 0 || m.yx != 0 || m.xx <= 0 || m.yy <= 0)
+            return false;
+
+         auto clip = cairo_copy_clip_rectangle_list(&context);
+         if (clip->status != CAIRO_STATUS_SUCCESS)
+         {
+            cairo_rectangle_list_destroy(clip);
+            return false;
+         }
+
+         // Call f with the pixels of each part of r within the clip
+         auto for_each_part = [&](auto f)
+         {
+            for (int i = 0; i != clip->num_rectangles; ++i)
+            {
+               auto const& cr = clip->rectangles[i];
+               struct rect part = {
+                  std::max<float>(r.left, cr.x), std::max<float>(r.top, cr.y)
+                , std::min<float>(r.right, cr.x + cr.width)
+                , std::min<float>(r.bottom, cr.y + cr.height)
+               };
+               if (part.left >= part.right || part.top >= part.bottom)
+                  continue;
+
+               long left, top, right, bottom;
+               if (!to_pixels(context, part.left, part.top, left, top)
+                  || !to_pixels(context, part.right, part.bottom, right, bottom))
+                  return false;
+               f(left, top, right, bottom);
+            }
+            return true;
+         };
+
+         // Check all the parts before touching any pixel
+         if (!for_each_part([](long, long, long, long) {}))
+         {
+            cairo_rectangle_list_destroy(clip);
+            return false;
+         }
+
+         // Out of range channels would spill into their neighbours
+         auto byte = [](float v)
+         {
+            return uint32_t(std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255));
+         };
+
+         uint32_t const pixel =
+            0xff000000 |
+            (byte(c.red) << 16) |
+            (byte(c.green) << 8) |
+            byte(c.blue)
+            ;
+
+         cairo_surface_flush(target);
+         auto data = cairo_image_surface_get_data(target);
+         auto stride = cairo_image_surface_get_stride(target);
+         long const width = cairo_image_surface_get_width(target);
+         long const height = cairo_image_surface_get_height(target);
+
+         for_each_part(
+            [&](long left, long top, long right, long bottom)
+            {
+               left = std::max(left, 0L);
+               top = std::max(top, 0L);
+               right = std::min(right, width);
+               bottom = std::min(bottom, height);
+               if (left >= right || top >= bottom)
+                  return;
+
+               for (long y = top; y != bottom; ++y)
+               {
+                  auto row = reinterpret_cast<uint32_t*>(data + y * stride);
+                  std::fill(row + left, row + right, pixel);
+               }
+               cairo_surface_mark_dirty_rectangle(
+                  target, left, top, right - left, bottom - top);
+            }
+         );
+
+         cairo_rectangle_list_destroy(clip);
+         return true;
+      }
+   }
+
+   namespace detail
+   {
+      // A path can be non-empty with no current point, e.g. right after
+      // new_sub_path, so ask for the path itself.
+      inline bool is_path_empty(cairo_t& context)
+      {
+         auto path = cairo_copy_path(&context);
+         bool const empty = path->status == CAIRO_STATUS_SUCCESS && path->num_data == 0;
+         cairo_path_destroy(path);
+         return empty;
+      }
    }
 
    inline void canvas::fill_rect(struct rect r)
    {
+      // Opaque fills of whole pixels go straight to memory when possible,
+      // or else skip antialiasing. This is only done on an empty path, as
+      // fill_rect fills whatever is in the path as well.
+      auto const& s = _state.fill_style;
+      bool const empty_path = detail::is_path_empty(_context);
+      if (empty_path && s.kind == style::solid && s.solid_color.alpha >= 1
+         && detail::fill_rect_direct(_context, r, s.solid_color))
+         return;
+
       rect(r);
-      fill();
+      if (empty_path && detail::is_pixel_aligned(_context, r))
+      {
+         auto aa = cairo_get_antialias(&_context);
+         cairo_set_antialias(&_context, CAIRO_ANTIALIAS_NONE);
+         fill();
+         cairo_set_antialias(&_context, aa);
+      }
+      else
+      {
+         fill();
+      }
    }
 
    inline void canvas::fill_round_rect(struct rect r, float radius)
@@ -281,6 +701,73 @@ namespace cycfi { namespace photon
       stroke();
    }
 
+   namespace detail
+   {
+      // Snap a user space coordinate c, along an axis with the given scale
+      // and offset to the pixels of the surface, so that a stroke w pixels
+      // wide covers whole pixels.
+      inline double snap(double c, double scale, double offset, double w)
+      {
+         auto d = c * scale + offset;
+         auto iw = std::round(std::abs(w));
+         d = (iw == 0 || std::fmod(iw, 2) == 1)? std::floor(d) + 0.5 : std::round(d);
+         return (d - offset) / scale;
+      }
+   }
+
+   inline void canvas::stroke_lines(line const* first, line const* last)
+   {
+      cairo_matrix_t m;
+      cairo_get_matrix(&_context, &m);
+      bool const rectilinear = m.xy == 0 && m.yx == 0 && m.xx != 0 && m.yy != 0;
+      auto const w = cairo_get_line_width(&_context);
+
+      // Snap to the pixels of the surface, past its device scale and offset
+      auto target = cairo_get_target(&_context);
+      double sx, sy, ox, oy;
+      cairo_surface_get_device_scale(target, &sx, &sy);
+      cairo_surface_get_device_offset(target, &ox, &oy);
+      double const xx = m.xx * sx, x0 = m.x0 * sx + ox;
+      double const yy = m.yy * sy, y0 = m.y0 * sy + oy;
+
+      cairo_new_path(&_context);
+      for (auto i = first; i != last; ++i)
+      {
+         double x1 = i->from.x, y1 = i->from.y;
+         double x2 = i->to.x, y2 = i->to.y;
+         if (rectilinear)
+         {
+            if (x1 == x2)
+               x1 = x2 = detail::snap(x1, xx, x0, w * xx);
+            else if (y1 == y2)
+               y1 = y2 = detail::snap(y1, yy, y0, w * yy);
+         }
+         cairo_move_to(&_context, x1, y1);
+         cairo_line_to(&_context, x2, y2);
+      }
+      stroke();
+   }
+
+   inline void canvas::fill_rects(struct rect const* first, struct rect const* last)
+   {
+      cairo_new_path(&_context);
+      for (auto i = first; i != last; ++i)
+         cairo_rectangle(&_context, i->left, i->top, i->width(), i->height());
+      fill();
+   }
+
+   inline void canvas::stroke_polyline(point const* first, point const* last)
+   {
+      if (first == last)
+         return;
+
+      cairo_new_path(&_context);
+      cairo_move_to(&_context, first->x, first->y);
+      for (auto i = first + 1; i != last; ++i)
+         cairo_line_to(&_context, i->x, i->y);
+      stroke();
+   }
+
    inline void canvas::font(char const* face, float size, int style)
    {
       cairo_font_slant_t slant = (style & italic) ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL;
@@ -464,25 +951,68 @@ namespace cycfi { namespace photon
 
    inline void canvas::restore()
    {
-      _state = _state_stack.top();
-      _state_stack.pop();
+      _state_stack.pop(_state);
       cairo_restore(&_context);
    }
 
+   inline void canvas::state_stack::push(canvas_state const& s)
+   {
+      if (_size < inline_size)
+         _inline[_size] = s;
+      else
+         _spill.push_back(s);
+      ++_size;
+   }
+
+   inline void canvas::state_stack::pop(canvas_state& s)
+   {
+      assert(_size > 0);
+      --_size;
+      if (_size < inline_size)
+      {
+         s = std::move(_inline[_size]);
+      }
+      else
+      {
+         s = std::move(_spill.back());
+         _spill.pop_back();
+      }
+   }
+
+   inline void canvas::apply(style const& s)
+   {
+      switch (s.kind)
+      {
+         case style::solid:
+            {
+               auto const& c = s.solid_color;
+               cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
+            }
+            break;
+
+         case style::pattern:
+            cairo_set_source(&_context, s.pattern_.get());
+            break;
+
+         default:
+            break;
+      }
+   }
+
    inline void canvas::apply_fill_style()
    {
-      if (_state.pattern_set != _state.fill_set && _state.fill_style)
+      if (_state.pattern_set != _state.fill_set && _state.fill_style.kind != style::none)
       {
-         _state.fill_style();
+         apply(_state.fill_style);
          _state.pattern_set = _state.fill_set;
       }
    }
 
    inline void canvas::apply_stroke_style()
    {
-      if (_state.pattern_set != _state.stroke_set && _state.stroke_style)
+      if (_state.pattern_set != _state.stroke_set && _state.stroke_style.kind != style::none)
       {
-         _state.stroke_style();
+         apply(_state.stroke_style);
          _state.pattern_set = _state.stroke_set;
       }
    }
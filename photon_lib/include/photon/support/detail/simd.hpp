@@ -0,0 +1,64 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_SIMD_MARCH_20_2019)
+#define CYCFI_PHOTON_GUI_LIB_SIMD_MARCH_20_2019
+
+////////////////////////////////////////////////////////////////////////////////
+// x86 SIMD support. SSE2 is the baseline (it is part of x86-64). Code for
+// later instruction sets is compiled per function with
+// CYCFI_PHOTON_TARGET, without special compiler flags, and picked at run
+// time with has_ssse3() and has_avx2().
+////////////////////////////////////////////////////////////////////////////////
+#if defined(__SSE2__) || defined(_M_X64)
+# define CYCFI_PHOTON_SSE2
+# include <immintrin.h>
+# if defined(_MSC_VER)
+#  include <intrin.h>
+#  define CYCFI_PHOTON_TARGET(isa)
+# else
+#  define CYCFI_PHOTON_TARGET(isa) __attribute__((target(isa)))
+# endif
+
+namespace cycfi { namespace photon { namespace detail
+{
+#if defined(_MSC_VER)
+   inline bool cpu_has_ssse3()
+   {
+      int info[4];
+      __cpuid(info, 1);
+      return (info[2] & (1 << 9)) != 0;
+   }
+
+   inline bool cpu_has_avx2()
+   {
+      int info[4];
+      __cpuid(info, 1);
+      bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+      if (!os_saves_ymm)
+         return false;
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+   }
+#else
+   inline bool cpu_has_ssse3() { return __builtin_cpu_supports("ssse3"); }
+   inline bool cpu_has_avx2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+   inline bool has_ssse3()
+   {
+      static bool const r = cpu_has_ssse3();
+      return r;
+   }
+
+   inline bool has_avx2()
+   {
+      static bool const r = cpu_has_avx2();
+      return r;
+   }
+}}}
+
+#endif
+#endif
@@ -17,6 +17,11 @@ namespace cycfi { namespace photon
    void draw_indicator(canvas& cnv, rect bounds, color c);
    void draw_thumb(canvas& cnv, circle cp, color c, color ic);
    void draw_track(canvas& cnv, rect bounds);
+
+   // Add a round rect or a circle to the current path. Unlike the canvas
+   // versions, the shapes are recorded once per size and reused.
+   void add_round_rect(canvas& cnv, rect bounds, float radius);
+   void add_circle(canvas& cnv, circle c);
 }}
 
 #endif
@@ -9,6 +9,8 @@
 #include <infra/assert.hpp>
 #include <photon/support/canvas.hpp>
 #include <photon/support/text_utils.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <stdexcept>
 #include <cairo.h>
@@ -20,6 +22,11 @@ namespace cycfi { namespace photon
    ////////////////////////////////////////////////////////////////////////////
    class master_glyphs;
 
+   namespace detail
+   {
+      struct ascii_glyphs;
+   }
+
    class glyphs
    {
    public:
@@ -29,6 +36,7 @@ namespace cycfi { namespace photon
                             , int cluster_start, int cluster_end
                             , master_glyphs const& master
                             , bool strip_leading_spaces
+                            , float pitch = 0
                            );
 
       void                 draw(point pos, canvas& canvas_);
@@ -37,12 +45,29 @@ namespace cycfi { namespace photon
                            // for_each F signature:
                            // bool f(char const* utf8, float left, float right);
                            template <typename F>
-      void                 for_each(F f);
+      void                 for_each(F f) const;
 
       std::size_t          size() const      { return _last - _first; }
       char const*          begin() const     { return _first; }
       char const*          end() const       { return _last; }
 
+      struct glyph_span
+      {
+         char const*       utf8;          // Null if there is no such glyph
+         float             left;          // From the start of the row
+         float             right;
+      };
+
+                           // The glyph at x, measured from the start of the
+                           // row, and the first glyph at or after s.
+      glyph_span           glyph_at(float x) const;
+      glyph_span           glyph_of(char const* s) const;
+
+                           // The advance of all glyphs if they are all the
+                           // same (e.g. monospace ASCII), else 0. Measuring
+                           // is then plain arithmetic.
+      float                pitch() const     { return _pitch; }
+
       struct font_metrics
       {
          float             ascent;
@@ -55,19 +80,37 @@ namespace cycfi { namespace photon
    protected:
                            glyphs(char const* first, char const* last);
 
+      friend class master_glyphs;
+
       using scaled_font = cairo_scaled_font_t;
-      using glyph = cairo_glyph_t;
-      using cluster = cairo_text_cluster_t;
       using cluster_flags = cairo_text_cluster_flags_t;
 
+      // Glyph runs are kept compact. Glyph positions are not stored, only
+      // each glyph's advance. The cairo glyphs, with absolute positions,
+      // are made for the rows being drawn only.
+      struct glyph
+      {
+         uint32_t          index;         // The glyph in the font
+         float             advance;       // Distance to the next glyph
+      };
+
+      struct cluster
+      {
+         uint8_t           num_bytes;     // UTF-8 bytes in the cluster
+         uint8_t           num_glyphs;    // Glyphs in the cluster
+      };
+
+      float                advance(cluster const& c, int glyph_index) const;
+
       char const*          _first;
       char const*          _last;
       scaled_font*         _scaled_font   = nullptr;
-      glyph*               _glyphs        = nullptr;
+      glyph const*         _glyphs        = nullptr;
       int                  _glyph_count   = 0;
-      cluster*             _clusters      = nullptr;
+      cluster const*       _clusters      = nullptr;
       int                  _cluster_count = 0;
-      cluster_flags        _clusterflags;
+      cluster_flags        _clusterflags  = cluster_flags(0);
+      float                _pitch         = 0;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -80,10 +123,16 @@ namespace cycfi { namespace photon
    class master_glyphs : public glyphs
    {
    public:
+                           // Fixed pitch fonts are detected. Pass the
+                           // canvas::monospace style to force ASCII text
+                           // on a fixed grid with any font. scale is the
+                           // device pixels per unit of the display the
+                           // text is for; metrics are hinted for it.
                            master_glyphs(
                               char const* first, char const* last
                             , char const* face, float size
                             , int style = canvas::normal
+                            , float scale = 1
                            );
 
                            master_glyphs(
@@ -91,24 +140,91 @@ namespace cycfi { namespace photon
                             , master_glyphs const& source
                            );
 
+                           // Join consecutive pieces of [first, last), each
+                           // shaped separately with the same font, into one.
+                           master_glyphs(
+                              char const* first, char const* last
+                            , std::vector<master_glyphs const*> const& parts
+                           );
+
                            master_glyphs(master_glyphs&&);
       master_glyphs&       operator=(master_glyphs&& rhs);
 
+                           // Where a part starts in the glyphs joined
+                           // from it
+      struct part_offset
+      {
+         std::ptrdiff_t    text = 0;      // bytes
+         int               glyph = 0;
+         int               cluster = 0;
+      };
+
+                           // Move rows broken from part, one of the parts
+                           // this was joined from, onto this. part starts
+                           // at offset, which is then moved past it.
+      void                 adopt_rows(
+                              master_glyphs const& part
+                            , std::vector<glyphs>& rows
+                            , part_offset& offset
+                           ) const;
+
                            ~master_glyphs();
 
       void                 break_lines(float width, std::vector<glyphs>& lines);
       void                 text(char const* first, char const* last);
 
+                           // Shape the text again for a display of another
+                           // scale. Rows from break_lines are invalidated.
+      void                 scale(float scale_);
+      float                scale() const { return _scale; }
+
+                           // Point to [first, last), an exact copy of the
+                           // text, without shaping it again (e.g. after the
+                           // string holding the text was moved).
+      void                 rebind(char const* first, char const* last);
+
+                           // The text is now [first, last): bytes [pos,
+                           // pos + n) of the old text were replaced by the
+                           // text of ins (shaped with the same font). The
+                           // rest is not shaped again.
+      void                 replace(
+                              char const* first, char const* last
+                            , std::size_t pos, std::size_t n
+                            , master_glyphs const& ins
+                           );
+
    private:
                            master_glyphs(master_glyphs const&) = delete;
       master_glyphs&       operator=(master_glyphs const& rhs) = delete;
 
       void                 build();
+      void                 shape(char const* first, char const* last);
+      void                 shape_ascii(char const* first, char const* last);
+      void                 update();
+      void                 init_grid();
+
+      using ascii_glyphs = detail::ascii_glyphs;
+
+      ascii_glyphs const*  _ascii = nullptr; // Set if ASCII is laid out on a grid
+      float                _grid = 0;        // The grid's pitch
+      bool                 _monospace = false;
+      float                _scale = 1;
+
+      std::vector<glyph>   _glyph_store;
+      std::vector<cluster> _cluster_store;
    };
 
    ////////////////////////////////////////////////////////////////////////////
+   inline float glyphs::advance(cluster const& c, int glyph_index) const
+   {
+      float r = 0;
+      for (auto i = glyph_index; i != glyph_index + c.num_glyphs; ++i)
+         r += _glyphs[i].advance;
+      return r;
+   }
+
    template <typename F>
-   inline void glyphs::for_each(F f)
+   inline void glyphs::for_each(F f) const
    {
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
       CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
@@ -119,22 +235,19 @@ namespace cycfi { namespace photon
 
       int   glyph_index = 0;
       int   byte_index = 0;
-      float start_x = _glyphs->x;
+      float x = 0;
 
       for (int i = 0; i < _cluster_count; i++)
       {
-         cairo_text_cluster_t* cluster = _clusters + i;
-         cairo_glyph_t* glyph = _glyphs + glyph_index;
-         cairo_text_extents_t extents;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-
-         float x = glyph->x - start_x;
-         if (!f(_first + byte_index, x, x + extents.x_advance))
+         auto const& cluster = _clusters[i];
+         auto right = x + advance(cluster, glyph_index);
+         if (!f(_first + byte_index, x, right))
             break;
 
          // glyph/byte position
-         glyph_index += cluster->num_glyphs;
-         byte_index += cluster->num_bytes;
+         x = right;
+         glyph_index += cluster.num_glyphs;
+         byte_index += cluster.num_bytes;
       }
    }
 }}
@@ -0,0 +1,63 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_HIT_SHAPE_MARCH_17_2019)
+#define CYCFI_PHOTON_GUI_LIB_HIT_SHAPE_MARCH_17_2019
+
+#include <photon/support/rect.hpp>
+#include <photon/support/circle.hpp>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Hit shapes: Analytic shapes for hit testing. Testing a point is plain
+   // arithmetic; no path and no canvas is needed. Polygons are filled with
+   // the nonzero winding rule, like canvas paths.
+   ////////////////////////////////////////////////////////////////////////////
+   class hit_shape
+   {
+   public:
+
+      enum kind_enum
+      {
+         none,
+         rect_shape,
+         round_rect_shape,
+         circle_shape,
+         ring_shape,
+         polygon_shape
+      };
+
+                        hit_shape() = default;
+
+      kind_enum         kind() const   { return _kind; }
+      rect              bounds() const { return _bounds; }
+      bool              includes(point p) const;
+      hit_shape         move(float dx, float dy) const;
+
+   private:
+
+      friend hit_shape  hit_rect(rect r);
+      friend hit_shape  hit_round_rect(rect r, float radius);
+      friend hit_shape  hit_circle(circle c);
+      friend hit_shape  hit_ring(circle c, float inner_radius);
+      friend hit_shape  hit_polygon(std::vector<point> points);
+
+      kind_enum         _kind = none;
+      rect              _bounds;
+      float             _radius = 0;         // Corner or outer radius
+      float             _inner_radius = 0;   // Rings only
+      std::vector<point> _points;            // Polygons only
+   };
+
+   hit_shape            hit_rect(rect r);
+   hit_shape            hit_round_rect(rect r, float radius);
+   hit_shape            hit_circle(circle c);
+   hit_shape            hit_ring(circle c, float inner_radius);
+   hit_shape            hit_polygon(std::vector<point> points);
+}}
+
+#endif
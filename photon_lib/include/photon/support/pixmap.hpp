@@ -11,6 +11,7 @@
 #include <cairo.h>
 #include <photon/support/point.hpp>
 #include <stdexcept>
+#include <cstdint>
 
 namespace cycfi { namespace photon
 {
@@ -51,6 +52,16 @@ namespace cycfi { namespace photon
 
    using pixmap_ptr = std::shared_ptr<pixmap>;
 
+   ////////////////////////////////////////////////////////////////////////////
+   // Pixel conversion
+   //
+   // premultiply_rgba converts n pixels of straight alpha RGBA bytes (as
+   // image decoders give them) to cairo's ARGB32: native endian 32 bit
+   // words with the colors premultiplied by alpha. src and dest may be
+   // the same buffer.
+   ////////////////////////////////////////////////////////////////////////////
+   void premultiply_rgba(uint8_t const* src, uint32_t* dest, std::size_t n);
+
    ////////////////////////////////////////////////////////////////////////////
    // pixmap_context allows drawing into a pixmap
    ////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,115 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_PIXMAP_REGISTRY_MARCH_19_2019)
+#define CYCFI_PHOTON_GUI_LIB_PIXMAP_REGISTRY_MARCH_19_2019
+
+#include <photon/support/pixmap.hpp>
+#include <photon/support/rect.hpp>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // pixmap_registry: Shares the pixmaps loaded from files. A file loaded
+   // at a given scale is decoded once and handed out to everyone who asks
+   // for it, for as long as it stays in the registry.
+   //
+   // The registry keeps the pixmaps alive even when no one else uses them,
+   // up to a budget (in decoded bytes). Past that, the least recently used
+   // pixmaps no one else holds are dropped. This is checked as pixmaps are
+   // added. Pixmaps still in use are never dropped, so the total may go
+   // over the budget.
+   //
+   // It also shares prescaled copies: pixmaps drawn from a source pixmap at
+   // a given size and device scale (e.g. an image stretched to its bounds,
+   // or a gizmo's patches put together). These count towards the same
+   // budget, and unused ones are dropped before the files.
+   //
+   // Safe to use from any thread.
+   ////////////////////////////////////////////////////////////////////////////
+   class pixmap_registry
+   {
+   public:
+
+      struct statistics
+      {
+         std::size_t       hits = 0;
+         std::size_t       misses = 0;
+         std::size_t       evictions = 0;
+         std::size_t       entries = 0;
+         std::size_t       bytes = 0;     // Decoded and prescaled bytes held
+      };
+
+      static constexpr std::size_t default_budget = 128 * 1024 * 1024;
+
+      explicit             pixmap_registry(std::size_t budget = default_budget);
+
+                           pixmap_registry(pixmap_registry const&) = delete;
+      pixmap_registry&     operator=(pixmap_registry const&) = delete;
+
+      using draw_function = std::function<void(canvas& cnv, rect bounds)>;
+
+      pixmap_ptr           get(char const* filename, float scale = 1);
+
+                           // The copy of source that f draws at the given
+                           // size and device scale. variant tells apart
+                           // different ways f may draw the same source.
+      pixmap_ptr           prescaled(
+                              pixmap_ptr const& source, int variant
+                            , point size, float scale, draw_function f
+                           );
+
+      std::size_t          budget() const;
+      void                 budget(std::size_t bytes);
+      statistics           stats() const;
+      void                 clear();       // Drops the pixmaps no one else holds
+
+   private:
+
+      using key_type = std::tuple<std::string, float>;
+      using lru_list = std::list<key_type>;
+
+      struct entry
+      {
+         pixmap_ptr        pixmap;
+         std::size_t       bytes;
+         lru_list::iterator lru;
+      };
+
+      using prescaled_key = std::tuple<pixmap const*, int, float, float, float>;
+      using prescaled_lru_list = std::list<prescaled_key>;
+
+      struct prescaled_entry
+      {
+         std::weak_ptr<photon::pixmap> source; // The address in the key may be reused
+         pixmap_ptr        pixmap;
+         std::size_t       bytes;
+         prescaled_lru_list::iterator lru;
+      };
+
+      template <typename Map, typename List>
+      void                 trim(Map& entries, List& lru, std::size_t budget);
+      void                 trim(std::size_t budget);
+
+      mutable std::mutex   _mutex;
+      std::map<key_type, entry> _entries;
+      lru_list             _lru;          // Most recently used first
+      std::map<prescaled_key, prescaled_entry> _prescaled;
+      prescaled_lru_list   _prescaled_lru;
+      std::size_t          _budget;
+      statistics           _stats;
+   };
+
+   // The registry images loaded from files go through
+   pixmap_registry&        get_pixmap_registry();
+}}
+
+#endif
@@ -0,0 +1,28 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_SHADOW_MARCH_14_2019)
+#define CYCFI_PHOTON_GUI_LIB_SHADOW_MARCH_14_2019
+
+#include <photon/support/canvas.hpp>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Drop shadows
+   //
+   // draw_shadow draws the soft shadow of a round rect. blur is how far
+   // (in user space) the shadow fades out past the edges of bounds. The
+   // shadow is a box blur (three passes, close to a gaussian) of the shape,
+   // rendered once per corner radius, blur, color and scale, and kept as a
+   // nine-patch that is stretched to any size.
+   ////////////////////////////////////////////////////////////////////////////
+   void draw_shadow(
+      canvas& cnv, rect bounds
+    , float corner_radius, float blur, color c
+   );
+}}
+
+#endif
@@ -0,0 +1,81 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_SHAPING_POOL_MARCH_9_2019)
+#define CYCFI_PHOTON_GUI_LIB_SHAPING_POOL_MARCH_9_2019
+
+#include <photon/support/glyphs.hpp>
+#include <photon/support/thread_pool.hpp>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // shaped_text: A string and its glyphs, shaped ahead of time. Pass it to
+   // a text box to skip shaping on the UI thread. scale is the device scale
+   // of the display the text is for (see base_view::scale). Text shaped for
+   // another scale is shaped again in the text box's first layout.
+   ////////////////////////////////////////////////////////////////////////////
+   struct shaped_text
+   {
+                           shaped_text(
+                              std::string text_
+                            , char const* face, float size
+                            , int style = canvas::normal
+                            , float scale = 1
+                           );
+
+                           shaped_text(shaped_text&& rhs);
+      shaped_text&         operator=(shaped_text&& rhs) = delete;
+
+      std::string          text;
+      master_glyphs        glyphs;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // shaping_pool: Shapes many strings in parallel on a fixed set of worker
+   // threads. Use it to build the text of a lot of text boxes at startup.
+   // Shaping errors are rethrown by the futures' get().
+   ////////////////////////////////////////////////////////////////////////////
+   class shaping_pool
+   {
+   public:
+
+                           // num_threads == 0: one per hardware thread
+      explicit             shaping_pool(std::size_t num_threads = 0);
+
+                           shaping_pool(shaping_pool const&) = delete;
+      shaping_pool&        operator=(shaping_pool const&) = delete;
+
+      std::future<shaped_text>
+                           shape(
+                              std::string text
+                            , char const* face, float size
+                            , int style = canvas::normal
+                            , float scale = 1
+                           );
+
+                           // Shape all the texts and wait for the results,
+                           // returned in the same order.
+      std::vector<shaped_text>
+                           shape_all(
+                              std::vector<std::string> texts
+                            , char const* face, float size
+                            , int style = canvas::normal
+                            , float scale = 1
+                           );
+
+      std::size_t          num_threads() const  { return _pool.num_threads(); }
+
+   private:
+
+      thread_pool          _pool;
+   };
+}}
+
+#endif
@@ -0,0 +1,91 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_TEXT_LOADER_MARCH_4_2019)
+#define CYCFI_PHOTON_GUI_LIB_TEXT_LOADER_MARCH_4_2019
+
+#include <photon/support/glyphs.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // text_loader: Reads a text file in the background, in chunks, shaping and
+   // breaking it into rows one block of paragraphs at a time. The UI thread
+   // polls for the blocks that are ready and can show them while the rest of
+   // the file is still loading. When everything is in, the blocks are joined
+   // into one master_glyphs spanning the whole text.
+   //
+   // Blocks are split just before a newline, so appending the rows of each
+   // block gives the same rows as breaking the whole text at once. (A single
+   // line longer than the block size is the exception. It gets split at a
+   // UTF-8 boundary instead.)
+   ////////////////////////////////////////////////////////////////////////////
+   class text_loader
+   {
+   public:
+
+      struct block
+      {
+                           block(
+                              char const* first, char const* last
+                            , master_glyphs const& font, float width_
+                           );
+
+         master_glyphs     glyphs;
+         std::vector<photon::glyphs> rows;
+         float             width;
+      };
+
+      using block_ptr = std::shared_ptr<block>;
+
+                           text_loader(char const* path, master_glyphs const& font);
+                           ~text_loader();
+
+                           text_loader(text_loader const&) = delete;
+      text_loader&         operator=(text_loader const&) = delete;
+
+      // Moves the blocks that are ready since the last poll to blocks.
+      void                 poll(std::vector<block_ptr>& blocks);
+
+      // Rows of blocks not yet shaped are broken at this width.
+      void                 width(float width_)  { _width = width_; }
+
+      bool                 done() const         { return _done; }
+      bool                 failed() const       { return _failed; }
+      std::size_t          size() const         { return _size; }
+
+      // Available only when done(). The glyphs refer to text().
+      std::string&         text()               { return _text; }
+      master_glyphs&       glyphs()             { return *_glyphs; }
+
+   private:
+
+      void                 load(std::string path);
+      void                 add_block(char const* first, char const* last);
+
+      std::atomic<bool>    _cancel;
+      std::atomic<bool>    _done;
+      std::atomic<bool>    _failed;
+      std::atomic<float>   _width;
+      std::atomic<std::size_t> _size;
+
+      std::mutex           _mutex;
+      std::vector<block_ptr> _ready;
+      std::vector<block_ptr> _blocks;
+
+      std::string          _text;
+      master_glyphs        _font;
+      std::unique_ptr<master_glyphs> _glyphs;
+      std::thread          _thread;
+   };
+}}
+
+#endif
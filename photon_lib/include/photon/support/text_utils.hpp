@@ -14,6 +14,17 @@ namespace cycfi { namespace photon
    ////////////////////////////////////////////////////////////////////////////
    void           draw_icon(canvas& cnv, rect bounds, uint32_t code, float size);
    void           draw_icon(canvas& cnv, rect bounds, uint32_t code, float size, color c);
+
+   // Icons are rasterized once per (code, size, color, scale) and blitted
+   // from then on. prewarm_icons renders the theme's icon set (or the given
+   // codes) ahead of time so the first frame does not pay for it.
+   void           prewarm_icons(float scale = 1);
+   void           prewarm_icons(
+                     uint32_t const codes[], std::size_t num_codes
+                   , float size, color c, float scale = 1
+                  );
+   void           clear_icon_cache();
+
    point          measure_icon(canvas& cnv, uint32_t cp, float size);
    point          measure_text(canvas& cnv, char const* text, char const* face, float size);
    std::string    codepoint_to_utf8(unsigned codepoint);
@@ -26,44 +37,71 @@ namespace cycfi { namespace photon
    unsigned       codepoint(char const*& utf8);
 
    ////////////////////////////////////////////////////////////////////////////
+   // Unicode line break (UAX #14) and word break (UAX #29) properties. These
+   // are looked up in O(1) from two-stage tables generated at compile time
+   // (see break_properties.cpp).
+   ////////////////////////////////////////////////////////////////////////////
+   enum class line_break_class : uint8_t
+   {
+      al, ai, b2, ba, bb, bk, cb, cj, cl, cm, cp, cr, eb, em, ex, gl,
+      h2, h3, hl, hy, id, in, is, jl, jt, jv, lf, nl, ns, nu, op, po,
+      pr, qu, ri, sa, sg, sp, sy, wj, xx, zw, zwj
+   };
+
+   enum class word_break_class : uint8_t
+   {
+      other, cr, lf, newline, extend, zwj, regional_indicator, format,
+      katakana, hebrew_letter, aletter, single_quote, double_quote,
+      midnumlet, midletter, midnum, numeric, extendnumlet, wsegspace
+   };
+
+   enum break_flag : uint8_t
+   {
+      cp_space          = 1
+    , cp_newline        = 2
+    , cp_punctuation    = 4
+   };
+
+   // Packed: line break class in bits 0-5, word break class in bits 6-10
+   // and break_flag bits in 11-13.
+   uint16_t       break_properties(unsigned codepoint);
+
+   // Is there a line break opportunity between two codepoints of the given
+   // classes? Spaces and mandatory breaks are not covered. This follows the
+   // pair rules of UAX #14 in a simplified form.
+   bool           is_line_break_opportunity(line_break_class before, line_break_class after);
+
+   inline line_break_class line_break_of(unsigned codepoint)
+   {
+      return line_break_class(break_properties(codepoint) & 0x3F);
+   }
+
+   inline word_break_class word_break_of(unsigned codepoint)
+   {
+      return word_break_class((break_properties(codepoint) >> 6) & 0x1F);
+   }
+
+   inline unsigned break_flags(unsigned codepoint)
+   {
+      return break_properties(codepoint) >> 11;
+   }
+
+   // Check if codepoint is a space (breaking white space or new line)
    inline bool is_space(unsigned codepoint)
    {
-      switch (codepoint)
-      {
-         case 9:        // \t
-         case 11:       // \v
-         case 12:       // \f
-         case 32:       // space
-			case 10:		   // \n
-			case 13:		   // \r
-         case 0xA0:     // NBSP
-            return true;
-         default:
-            return false;
-      }
+      return break_flags(codepoint) & cp_space;
    }
 
    // Check if codepoint is a new line
    inline bool is_newline(unsigned codepoint)
    {
-      switch (codepoint)
-      {
-			case 10:		   // \n
-			case 13:		   // \r
-			case 0x85:	   // NEL
-            return true;
-         default:
-            return false;
-      }
+      return break_flags(codepoint) & cp_newline;
    }
 
    // Check if codepoint is a punctuation
    inline bool is_punctuation(unsigned codepoint)
    {
-      return (codepoint < 0x80 && std::ispunct(codepoint))
-         || (codepoint >= 0xA0 && codepoint <= 0xBF)
-         || (codepoint >= 0x2000 && codepoint <= 0x206F)
-         ;
+      return break_flags(codepoint) & cp_punctuation;
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -163,6 +201,9 @@ namespace cycfi { namespace photon
    ////////////////////////////////////////////////////////////////////////////
    inline unsigned codepoint(char const*& utf8)
    {
+      if (uint8_t(*utf8) < 0x80)
+         return uint8_t(*utf8++);
+
       unsigned state = 0;
       unsigned cp;
       while (decode_utf8(state, cp, uint8_t(*utf8)))
@@ -170,6 +211,37 @@ namespace cycfi { namespace photon
       ++utf8; // one past the last byte
       return cp;
    }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Bulk UTF8 scanning
+   //
+   // These work on whole runs of text. ASCII runs are scanned 32 or 16 bytes
+   // at a time with AVX2 or SSE2 when the compiler targets them (8 bytes at
+   // a time otherwise). Only the non-ASCII bytes go through the DFA.
+   ////////////////////////////////////////////////////////////////////////////
+   struct decoded_codepoint
+   {
+      char const*       pos;        // Start of the utf8 sequence
+      unsigned          codepoint;
+      unsigned          flags;      // break_flag bits
+      line_break_class  line_break;
+      word_break_class  word_break;
+   };
+
+   // Returns the first byte in [first, last) that is not ASCII, or last.
+   char const*    find_non_ascii(char const* first, char const* last);
+
+   // Returns the start of the first invalid or truncated utf8 sequence in
+   // [first, last), or last if all of it is valid.
+   char const*    validate_utf8(char const* first, char const* last);
+
+   // Decodes up to max codepoints from [first, last) into out and advances
+   // first past them. Returns the number of codepoints decoded. An invalid
+   // sequence decodes to U+FFFD, one byte at a time.
+   std::size_t    decode_utf8(
+                     char const*& first, char const* last
+                   , decoded_codepoint out[], std::size_t max
+                  );
 }}
 
 #endif
@@ -0,0 +1,50 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_THREAD_POOL_MARCH_16_2019)
+#define CYCFI_PHOTON_GUI_LIB_THREAD_POOL_MARCH_16_2019
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // thread_pool: A fixed set of worker threads running posted tasks in
+   // order. Pending tasks are finished before the pool is destroyed.
+   ////////////////////////////////////////////////////////////////////////////
+   class thread_pool
+   {
+   public:
+
+      using task = std::function<void()>;
+
+                           // num_threads == 0: one per hardware thread
+      explicit             thread_pool(std::size_t num_threads = 0);
+                           ~thread_pool();
+
+                           thread_pool(thread_pool const&) = delete;
+      thread_pool&         operator=(thread_pool const&) = delete;
+
+      void                 post(task t);
+      std::size_t          num_threads() const  { return _threads.size(); }
+
+   private:
+
+      void                 run();
+
+      std::mutex           _mutex;
+      std::condition_variable _ready;
+      std::deque<task>     _tasks;
+      bool                 _stop = false;
+      std::vector<std::thread> _threads;
+   };
+}}
+
+#endif
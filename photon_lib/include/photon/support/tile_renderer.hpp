@@ -0,0 +1,52 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_PHOTON_GUI_LIB_TILE_RENDERER_MARCH_16_2019)
+#define CYCFI_PHOTON_GUI_LIB_TILE_RENDERER_MARCH_16_2019
+
+#include <photon/support/canvas.hpp>
+#include <photon/support/thread_pool.hpp>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // tile_renderer: Rasterizes a display list in parallel. The area to draw
+   // is split into tiles of tile_size x tile_size device pixels, each one
+   // replayed into an image surface of its own on a worker thread, then
+   // the tiles are composited into the target canvas, in order.
+   //
+   // A cairo recording may not be replayed by two threads at once, so each
+   // worker replays a copy of the display list of its own. Record it at
+   // the target's device scale (see canvas::record).
+   ////////////////////////////////////////////////////////////////////////////
+   class tile_renderer
+   {
+   public:
+
+      static constexpr int default_tile_size = 256;
+
+                           // num_threads == 0: one per hardware thread
+      explicit             tile_renderer(
+                              std::size_t num_threads = 0
+                            , int tile_size = default_tile_size
+                           );
+
+      void                 render(
+                              canvas& target
+                            , canvas::display_list const& dl
+                            , rect area
+                           );
+
+      std::size_t          num_threads() const  { return _pool.num_threads(); }
+      int                  tile_size() const    { return _tile_size; }
+
+   private:
+
+      thread_pool          _pool;
+      int                  _tile_size;
+   };
+}}
+
+#endif
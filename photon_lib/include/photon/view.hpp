@@ -10,10 +10,12 @@
 #include <photon/support/rect.hpp>
 #include <photon/support/canvas.hpp>
 #include <photon/support/theme.hpp>
+#include <photon/support/tile_renderer.hpp>
 #include <photon/element/element.hpp>
 #include <photon/element/layer.hpp>
 #include <functional>
 #include <memory>
+#include <stack>
 
 namespace cycfi { namespace photon
 {
@@ -33,12 +35,25 @@ namespace cycfi { namespace photon
       virtual void         key(key_info const& k) override;
       virtual void         text(text_info const& info) override;
       virtual void         focus(focus_request r) override;
+      virtual void         idle() override;
 
-      using base_view::refresh;
-
+      void                 refresh();
+      void                 refresh(rect area);
       void                 refresh(element& element);
       void                 refresh(context const& ctx);
+
+                           // The number of refreshes asked for so far.
+                           // Compare it across a call to tell whether the
+                           // call asked for one.
+      std::size_t          refresh_count() const { return _refresh_count; }
       rect                 dirty() const { return _dirty; }
+      void                 dirty(rect area) { _dirty = area; }
+
+                           // Record the drawing of the damage region, then
+                           // rasterize it in tiles on worker threads.
+                           // num_threads == 0: one per hardware thread.
+      void                 tiled_rendering(bool enable, std::size_t num_threads = 0);
+      bool                 tiled_rendering() const { return bool(_tiles); }
 
       struct undo_redo_task
       {
@@ -66,7 +81,10 @@ namespace cycfi { namespace photon
       bool                 set_limits();
 
       rect                 _dirty;
+      std::size_t          _refresh_count = 0;
       rect                 _current_bounds;
+      float                _current_scale = 1;
+      std::unique_ptr<tile_renderer> _tiles;
       view_limits          _current_limits;
 
       using undo_stack_type = std::stack<undo_redo_task>;
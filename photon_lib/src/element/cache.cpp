@@ -0,0 +1,145 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/element/cache.hpp>
+#include <photon/view.hpp>
+
+namespace cycfi { namespace photon
+{
+   bool draw_cache_base::is_cached(context const& ctx) const
+   {
+      return !_display_list.empty()
+         && _recorded_generation == _generation
+         && ctx.bounds.width() == _bounds.width()
+         && ctx.bounds.height() == _bounds.height()
+         && ctx.canvas.device_scale() == _scale
+         ;
+   }
+
+   void draw_cache_base::draw(context const& ctx)
+   {
+      if (!is_cached(ctx))
+      {
+         // Record all of the subject, not just the part that needs to be
+         // drawn now.
+         auto dirty = ctx.view.dirty();
+         ctx.view.dirty(ctx.bounds);
+
+         _display_list = canvas::record(
+            [&](canvas& cnv)
+            {
+               context rctx { ctx.view, cnv, ctx.element, ctx.bounds };
+               rctx.parent = ctx.parent;
+               proxy_base::draw(rctx);
+            }
+          , ctx.canvas.device_scale()
+         );
+         ctx.view.dirty(dirty);
+
+         _bounds = ctx.bounds;
+         _scale = ctx.canvas.device_scale();
+         _recorded_generation = _generation;
+      }
+
+      ctx.canvas.replay(
+         _display_list
+       , { ctx.bounds.left - _bounds.left, ctx.bounds.top - _bounds.top }
+      );
+   }
+
+   void draw_cache_base::layout(context const& ctx)
+   {
+      invalidate();
+      proxy_base::layout(ctx);
+   }
+
+   void draw_cache_base::refresh(context const& ctx, element& element)
+   {
+      // The element refreshed may be anywhere inside the subject. If it is,
+      // the view was asked for a refresh along the way.
+      auto count = ctx.view.refresh_count();
+      proxy_base::refresh(ctx, element);
+      if (ctx.view.refresh_count() != count)
+         invalidate();
+   }
+
+   bool draw_cache_base::scroll(context const& ctx, point dir, point p)
+   {
+      invalidate();
+      return proxy_base::scroll(ctx, dir, p);
+   }
+
+   void draw_cache_base::idle(basic_context const& ctx)
+   {
+      auto count = ctx.view.refresh_count();
+      proxy_base::idle(ctx);
+      if (ctx.view.refresh_count() != count)
+         invalidate();
+   }
+
+   element* draw_cache_base::click(context const& ctx, mouse_button btn)
+   {
+      invalidate();
+      return proxy_base::click(ctx, btn);
+   }
+
+   void draw_cache_base::drag(context const& ctx, mouse_button btn)
+   {
+      invalidate();
+      proxy_base::drag(ctx, btn);
+   }
+
+   bool draw_cache_base::key(context const& ctx, key_info k)
+   {
+      invalidate();
+      return proxy_base::key(ctx, k);
+   }
+
+   bool draw_cache_base::text(context const& ctx, text_info info)
+   {
+      invalidate();
+      return proxy_base::text(ctx, info);
+   }
+
+   bool draw_cache_base::cursor(context const& ctx, point p, cursor_tracking status)
+   {
+      // Hovering is sent on every mouse move. Only let the cache go if the
+      // subject took it, or as the cursor comes and goes.
+      bool r = proxy_base::cursor(ctx, p, status);
+      if (r || status != cursor_tracking::hovering)
+         invalidate();
+      return r;
+   }
+
+   bool draw_cache_base::focus(focus_request r)
+   {
+      invalidate();
+      return proxy_base::focus(r);
+   }
+
+   void draw_cache_base::value(bool val)
+   {
+      invalidate();
+      proxy_base::value(val);
+   }
+
+   void draw_cache_base::value(int val)
+   {
+      invalidate();
+      proxy_base::value(val);
+   }
+
+   void draw_cache_base::value(double val)
+   {
+      invalidate();
+      proxy_base::value(val);
+   }
+
+   void draw_cache_base::value(std::string val)
+   {
+      invalidate();
+      proxy_base::value(val);
+   }
+}}
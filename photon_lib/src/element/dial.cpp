@@ -110,33 +110,38 @@ namespace cycfi { namespace photon
       auto const& theme = get_theme();
 
       cnv.translate({ center.x, center.y });
-      cnv.stroke_style(theme.ticks_color);
+
+      // Major and minor ticks, one stroke for each
+      canvas::line   major[num_divs+1];
+      canvas::line   minor[num_divs+1];
+      int            num_major = 0;
+      int            num_minor = 0;
       for (int i = 0; i != num_divs+1; ++i)
       {
+         bool is_minor = i % (num_divs / 10);
          float from = cp.radius;
-         if (i % (num_divs / 10))
-         {
-            // Minor ticks
+         if (is_minor)
             from -= size / 4;
-            cnv.line_width(theme.minor_ticks_width);
-            cnv.stroke_style(c.level(theme.minor_ticks_level));
-         }
-         else
-         {
-            // Major ticks
-            cnv.line_width(theme.major_ticks_width);
-            cnv.stroke_style(c.level(theme.major_ticks_level));
-         }
 
          float angle = offset + (M_PI / 2) + (i * div);
          float sin_ = std::sin(angle);
          float cos_ = std::cos(angle);
          float to = cp.radius - (size / 2);
 
-         cnv.move_to({ from * cos_, from * sin_ });
-         cnv.line_to({ to * cos_, to * sin_ });
-         cnv.stroke();
+         canvas::line l = { { from * cos_, from * sin_ }, { to * cos_, to * sin_ } };
+         if (is_minor)
+            minor[num_minor++] = l;
+         else
+            major[num_major++] = l;
       }
+
+      cnv.line_width(theme.minor_ticks_width);
+      cnv.stroke_style(c.level(theme.minor_ticks_level));
+      cnv.stroke_lines(minor, minor + num_minor);
+
+      cnv.line_width(theme.major_ticks_width);
+      cnv.stroke_style(c.level(theme.major_ticks_level));
+      cnv.stroke_lines(major, major + num_major);
    }
 
    void draw_radial_labels(
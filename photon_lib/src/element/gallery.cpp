@@ -6,6 +6,7 @@
 #include <photon/element/gallery.hpp>
 #include <photon/support/text_utils.hpp>
 #include <photon/support/draw_utils.hpp>
+#include <photon/support/shadow.hpp>
 #include <photon/support/theme.hpp>
 
 namespace cycfi { namespace photon
@@ -390,6 +391,19 @@ namespace cycfi { namespace photon
       auto&       canvas_ = ctx.canvas;
       auto const& bounds = ctx.bounds;
 
+      // Drop shadow, outside the menu only. The background is not opaque.
+      {
+         auto save = canvas_.new_state();
+
+         canvas_.begin_path();
+         canvas_.rect(bounds.inset(-100, -100));
+         draw_menu_background(canvas_.cairo_context(), bounds.inset(0.5, 0.5), 5);
+         canvas_.fill_rule(canvas::fill_odd_even);
+         canvas_.clip();
+
+         draw_shadow(canvas_, bounds.move(0, 2), 5, 6, rgba(0, 0, 0, 96));
+      }
+
       canvas_.begin_path();
       draw_menu_background(canvas_.cairo_context(), bounds, 5);
       canvas_.fill_style(get_theme().panel_color.opacity(0.95));
@@ -441,30 +455,25 @@ namespace cycfi { namespace photon
       auto&          canvas_ = ctx.canvas;
       auto const&    bounds = ctx.bounds;
 
-      float pos = bounds.top;
-      float incr = bounds.height() / _major_divisions;
+      // The divisions are not bounded. _lines is kept between draws, so
+      // it only allocates when it grows.
+      auto& lines = _lines;
+      auto add_lines = [&](float divisions)
+      {
+         lines.clear();
+         float incr = bounds.height() / divisions;
+         for (float pos = bounds.top; pos <= bounds.bottom+1; pos += incr)
+            lines.push_back({ { bounds.left, pos }, { bounds.right, pos } });
+      };
 
+      add_lines(_major_divisions);
       canvas_.stroke_style(theme_.major_grid_color);
       canvas_.line_width(theme_.major_grid_width);
-      while (pos <= bounds.bottom+1)
-      {
-         canvas_.move_to({ bounds.left, pos });
-         canvas_.line_to({ bounds.right, pos });
-         canvas_.stroke();
-         pos += incr;
-      }
-
-      pos = bounds.top;
-      incr = bounds.height() / _minor_divisions;
+      canvas_.stroke_lines(lines.data(), lines.data() + lines.size());
 
+      add_lines(_minor_divisions);
       canvas_.stroke_style(theme_.minor_grid_color);
       canvas_.line_width(theme_.minor_grid_width);
-      while (pos <= bounds.bottom+1)
-      {
-         canvas_.move_to({ bounds.left, pos });
-         canvas_.line_to({ bounds.right, pos });
-         canvas_.stroke();
-         pos += incr;
-      }
+      canvas_.stroke_lines(lines.data(), lines.data() + lines.size());
    }
 }}
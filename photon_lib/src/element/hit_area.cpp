@@ -0,0 +1,37 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/element/hit_area.hpp>
+#include <photon/view.hpp>
+
+namespace cycfi { namespace photon
+{
+   hit_area_base::hit_area_base(hit_shape shape)
+    : _shape(std::move(shape))
+   {}
+
+   hit_area_base::hit_area_base(shape_function f)
+    : _shape_f(std::move(f))
+   {}
+
+   hit_shape const& hit_area_base::shape(rect bounds)
+   {
+      point size = { bounds.width(), bounds.height() };
+      if (_shape_f && (size.x != _size.x || size.y != _size.y))
+      {
+         _shape = _shape_f({ 0, 0, size.x, size.y });
+         _size = size;
+      }
+      return _shape;
+   }
+
+   element* hit_area_base::hit_test(context const& ctx, point p)
+   {
+      auto local = p.move(-ctx.bounds.left, -ctx.bounds.top);
+      if (!shape(ctx.bounds).includes(local))
+         return 0;
+      return proxy_base::hit_test(ctx, p);
+   }
+}}
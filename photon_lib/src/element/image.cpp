@@ -6,14 +6,36 @@
 #include <photon/element/image.hpp>
 #include <photon/support.hpp>
 #include <photon/support/context.hpp>
+#include <photon/support/pixmap_registry.hpp>
+#include <photon/view.hpp>
+#include <cmath>
 
 namespace cycfi { namespace photon
 {
+   namespace
+   {
+      // Like canvas::draw, but resampled with the best (and slowest)
+      // filter, for drawing into prescaled copies.
+      void draw_best(canvas& cnv, pixmap const& pm, rect src, rect dest)
+      {
+         auto& context = cnv.cairo_context();
+         auto state = cnv.new_state();
+         cnv.translate(dest.top_left());
+         cnv.scale({ dest.width() / src.width(), dest.height() / src.height() });
+         cairo_set_source_surface(&context, pm._surface, -src.left, -src.top);
+         auto pattern = cairo_get_source(&context);
+         cairo_pattern_set_filter(pattern, CAIRO_FILTER_BEST);
+         cairo_pattern_set_extend(pattern, CAIRO_EXTEND_PAD);
+         cairo_rectangle(&context, 0, 0, src.width(), src.height());
+         cairo_fill(&context);
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // image implementation
    ////////////////////////////////////////////////////////////////////////////
    image::image(char const* filename, float scale)
-    : _pixmap(std::make_shared<photon::pixmap>(filename, scale))
+    : _pixmap(get_pixmap_registry().get(filename, scale))
    {
    }
 
@@ -21,9 +43,25 @@ namespace cycfi { namespace photon
     : _pixmap(pixmap_)
    {}
 
+   image::image(async_pixmap_ptr pixmap_, color placeholder)
+    : _async(pixmap_)
+    , _placeholder(placeholder)
+   {}
+
    point image::size() const
    {
-      return _pixmap->size();
+      return _pixmap ? _pixmap->size() : _async->size();
+   }
+
+   bool image::is_loading()
+   {
+      if (_pixmap || !_async || _failed)
+         return false;
+      if (!_async->ready())
+         return true;
+      _pixmap = _async->get();
+      _failed = !_pixmap;
+      return false;
    }
 
    rect image::source_rect(context const& ctx) const
@@ -39,8 +77,74 @@ namespace cycfi { namespace photon
 
    void image::draw(context const& ctx)
    {
+      if (is_loading())
+      {
+         _async->prioritize();
+         ctx.view.request_idle();   // To see when it is done
+         if (_placeholder.alpha > 0)
+         {
+            ctx.canvas.fill_style(_placeholder);
+            ctx.canvas.fill_rect(ctx.bounds);
+         }
+         return;
+      }
+
+      if (!_pixmap)  // Failed to load
+         return;
+
       auto src = source_rect(ctx);
-      ctx.canvas.draw(pixmap(), src, ctx.bounds);
+      auto fx = ctx.bounds.width() / src.width();
+      auto fy = ctx.bounds.height() / src.height();
+      if (fx == 1 && fy == 1)
+      {
+         ctx.canvas.draw(pixmap(), src, ctx.bounds);
+         return;
+      }
+
+      // Scale all of the pixmap, not just src, so that sprites do not need
+      // a new copy for each frame.
+      auto size_ = size();
+      auto const& pm = prescaled(ctx, prescale_whole, { size_.x * fx, size_.y * fy },
+         [this, size_](canvas& cnv, rect bounds)
+         {
+            draw_best(cnv, pixmap(), { 0, 0, size_.x, size_.y }, bounds);
+         }
+      );
+      ctx.canvas.draw(
+         pm, { src.left * fx, src.top * fy, src.right * fx, src.bottom * fy }
+       , ctx.bounds
+      );
+   }
+
+   photon::pixmap const& image::prescaled(
+      context const& ctx, prescale_kind kind
+    , point size, draw_function f
+   )
+   {
+      // Go to the registry only when the size or scale changed
+      auto scale = ctx.canvas.device_scale();
+      if (!_prescaled || size.x != _prescaled_size.x || size.y != _prescaled_size.y
+         || scale != _prescaled_scale)
+      {
+         _prescaled = nullptr;   // Let the registry drop the old copy
+         _prescaled = get_pixmap_registry().prescaled(_pixmap, kind, size, scale, f);
+         _prescaled_size = size;
+         _prescaled_scale = scale;
+      }
+      return *_prescaled;
+   }
+
+   void image::idle(basic_context const& ctx)
+   {
+      if (_pixmap || !_async || _failed)
+         return;
+
+      // Done loading since the last time around: replace the placeholder
+      // with the pixels, or with nothing if loading failed.
+      if (is_loading())
+         ctx.view.request_idle();
+      else
+         ctx.view.refresh(*this);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -112,16 +216,24 @@ namespace cycfi { namespace photon
 
    void gizmo::draw(context const& ctx)
    {
-      rect  src[9];
-      rect  dest[9];
       auto  size_ = size();
       rect  src_bounds{ 0, 0, size_.x, size_.y };
-
-      gizmo_parts(src_bounds, src_bounds, src);
-      gizmo_parts(src_bounds, ctx.bounds, dest);
-
-      for (int i = 0; i < 9; i++)
-         ctx.canvas.draw(pixmap(), src[i], dest[i]);
+      rect  local{ 0, 0, ctx.bounds.width(), ctx.bounds.height() };
+
+      auto const& pm = prescaled(ctx, prescale_gizmo, local.bottom_right(),
+         [&](canvas& cnv, rect bounds)
+         {
+            rect  src[9];
+            rect  dest[9];
+
+            gizmo_parts(src_bounds, src_bounds, src);
+            gizmo_parts(src_bounds, bounds, dest);
+
+            for (int i = 0; i < 9; i++)
+               draw_best(cnv, pixmap(), src[i], dest[i]);
+         }
+      );
+      ctx.canvas.draw(pm, local, ctx.bounds);
    }
 
    hgizmo::hgizmo(char const* filename, float scale)
@@ -140,16 +252,24 @@ namespace cycfi { namespace photon
 
    void hgizmo::draw(context const& ctx)
    {
-      rect  src[3];
-      rect  dest[3];
       auto  size_ = size();
       rect  src_bounds{ 0, 0, size_.x, size_.y };
-
-      hgizmo_parts(src_bounds, src_bounds, src);
-      hgizmo_parts(src_bounds, ctx.bounds, dest);
-      ctx.canvas.draw(pixmap(), src[0], dest[0]);
-      ctx.canvas.draw(pixmap(), src[1], dest[1]);
-      ctx.canvas.draw(pixmap(), src[2], dest[2]);
+      rect  local{ 0, 0, ctx.bounds.width(), ctx.bounds.height() };
+
+      auto const& pm = prescaled(ctx, prescale_hgizmo, local.bottom_right(),
+         [&](canvas& cnv, rect bounds)
+         {
+            rect  src[3];
+            rect  dest[3];
+
+            hgizmo_parts(src_bounds, src_bounds, src);
+            hgizmo_parts(src_bounds, bounds, dest);
+            draw_best(cnv, pixmap(), src[0], dest[0]);
+            draw_best(cnv, pixmap(), src[1], dest[1]);
+            draw_best(cnv, pixmap(), src[2], dest[2]);
+         }
+      );
+      ctx.canvas.draw(pm, local, ctx.bounds);
    }
 
    vgizmo::vgizmo(char const* filename, float scale)
@@ -168,16 +288,24 @@ namespace cycfi { namespace photon
 
    void vgizmo::draw(context const& ctx)
    {
-      rect  src[3];
-      rect  dest[3];
       auto  size_ = size();
       rect  src_bounds{ 0, 0, size_.x, size_.y };
-
-      vgizmo_parts(src_bounds, src_bounds, src);
-      vgizmo_parts(src_bounds, ctx.bounds, dest);
-      ctx.canvas.draw(pixmap(), src[0], dest[0]);
-      ctx.canvas.draw(pixmap(), src[1], dest[1]);
-      ctx.canvas.draw(pixmap(), src[2], dest[2]);
+      rect  local{ 0, 0, ctx.bounds.width(), ctx.bounds.height() };
+
+      auto const& pm = prescaled(ctx, prescale_vgizmo, local.bottom_right(),
+         [&](canvas& cnv, rect bounds)
+         {
+            rect  src[3];
+            rect  dest[3];
+
+            vgizmo_parts(src_bounds, src_bounds, src);
+            vgizmo_parts(src_bounds, bounds, dest);
+            draw_best(cnv, pixmap(), src[0], dest[0]);
+            draw_best(cnv, pixmap(), src[1], dest[1]);
+            draw_best(cnv, pixmap(), src[2], dest[2]);
+         }
+      );
+      ctx.canvas.draw(pm, local, ctx.bounds);
    }
 
    sprite::sprite(char const* filename, float height, float scale)
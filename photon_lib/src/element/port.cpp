@@ -5,6 +5,8 @@
 =============================================================================*/
 #include <photon/element/port.hpp>
 #include <photon/view.hpp>
+#include <photon/support/draw_utils.hpp>
+#include <photon/support/hit_shape.hpp>
 #include <algorithm>
 #include <cmath>
 
@@ -99,9 +101,8 @@ namespace cycfi { namespace photon
       void draw_scrollbar_fill(canvas& _canvas, rect r, color fill_color)
       {
          _canvas.begin_path();
-         _canvas.rect(r);
          _canvas.fill_style(fill_color);
-         _canvas.fill();
+         _canvas.fill_rect(r);
       }
 
       void draw_scrollbar(
@@ -111,10 +112,10 @@ namespace cycfi { namespace photon
       )
       {
          _canvas.begin_path();
-         _canvas.round_rect(b, radius);
+         add_round_rect(_canvas, b, radius);
          _canvas.fill_style(fill_color);
 
-         if (is_tracking || _canvas.hit_test(mp))
+         if (is_tracking || hit_round_rect(b, radius).includes(mp))
             _canvas.fill_style(fill_color.opacity(0.8));
 
          _canvas.fill_preserve();
@@ -218,37 +218,31 @@ namespace cycfi { namespace photon
       auto state = cnv.new_state();
       auto const& theme = get_theme();
 
-      cnv.stroke_style(theme.ticks_color);
+      // Major and minor ticks, one stroke for each
+      canvas::line   major[num_divs+1];
+      canvas::line   minor[num_divs+1];
+      int            num_major = 0;
+      int            num_minor = 0;
       for (int i = 0; i != num_divs+1; ++i)
       {
-         float inset = 0;
-         if (i % (num_divs / 10))
-         {
-            // Minor ticks
-            inset = size / 6;
-            cnv.line_width(theme.minor_ticks_width);
-            cnv.stroke_style(c.level(theme.minor_ticks_level));
-         }
-         else
-         {
-            // Major ticks
-            cnv.line_width(theme.major_ticks_width);
-            cnv.stroke_style(c.level(theme.major_ticks_level));
-         }
+         bool is_minor = i % (num_divs / 10);
+         float inset = is_minor? size / 6 : 0;
 
+         auto& l = is_minor? minor[num_minor++] : major[num_major++];
          if (vertical)
-         {
-            cnv.move_to({ bounds.left + inset, pos });
-            cnv.line_to({ bounds.right - inset, pos });
-         }
+            l = { { bounds.left + inset, pos }, { bounds.right - inset, pos } };
          else
-         {
-            cnv.move_to({ pos, bounds.top + inset });
-            cnv.line_to({ pos, bounds.bottom - inset });
-         }
-         cnv.stroke();
+            l = { { pos, bounds.top + inset }, { pos, bounds.bottom - inset } };
          pos += incr;
       }
+
+      cnv.line_width(theme.minor_ticks_width);
+      cnv.stroke_style(c.level(theme.minor_ticks_level));
+      cnv.stroke_lines(minor, minor + num_minor);
+
+      cnv.line_width(theme.major_ticks_width);
+      cnv.stroke_style(c.level(theme.major_ticks_level));
+      cnv.stroke_lines(major, major + num_major);
    }
 
    void draw_slider_labels(
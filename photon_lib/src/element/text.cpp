@@ -9,6 +9,10 @@
 #include <photon/support/text_utils.hpp>
 #include <photon/support/context.hpp>
 #include <photon/view.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
 
 namespace cycfi { namespace photon
 {
@@ -27,6 +31,17 @@ namespace cycfi { namespace photon
     , _color(color_)
    {}
 
+   static_text_box::static_text_box(shaped_text&& text, color color_)
+    : _text(std::move(text.text))
+    , _layout(std::move(text.glyphs))
+    , _color(color_)
+   {
+      // Short text lives inside the string itself and does not keep its
+      // address when moved.
+      if (_layout.begin() != _text.data())
+         _layout.rebind(_text.data(), _text.data() + _text.size());
+   }
+
    view_limits static_text_box::limits(basic_context const& ctx) const
    {
       auto  size = _layout.metrics();
@@ -45,9 +60,19 @@ namespace cycfi { namespace photon
 
    void static_text_box::layout(context const& ctx)
    {
+      // Shape again only if the display scale changed
+      _layout.scale(ctx.view.scale());
+
       _rows.clear();
+      ++_layout_count;
       auto  new_x = ctx.bounds.width();
       _layout.break_lines(new_x, _rows);
+      if (_loader)
+      {
+         _loader->width(new_x);
+         for (auto const& block : _blocks)
+            add_rows(*block, new_x);
+      }
       auto  size = _layout.metrics();
       auto  new_y = _rows.size() * (size.ascent + size.descent + size.leading);
 
@@ -61,6 +86,10 @@ namespace cycfi { namespace photon
 
    void static_text_box::draw(context const& ctx)
    {
+      // Idle takes in the blocks as they are loaded
+      if (_loader)
+         ctx.view.request_idle();
+
       auto& cnv = ctx.canvas;
       auto  state = cnv.new_state();
       auto  metrics = _layout.metrics();
@@ -71,23 +100,151 @@ namespace cycfi { namespace photon
       cnv.rect(ctx.bounds);
       cnv.clip();
       cnv.fill_style(_color);
-      for (auto& row : _rows)
+
+      // Skip the rows above the dirty area. Long documents in a scroller
+      // have most of their rows out of sight.
+      auto  i = _rows.begin();
+      auto  skip = std::floor((ctx.view.dirty().top - ctx.bounds.top) / line_height);
+      if (skip > 0)
       {
-         row.draw({ x, y }, cnv);
+         auto n = std::min(std::size_t(skip), _rows.size());
+         i += n;
+         y += n * line_height;
+      }
+
+      auto  bottom = std::min(ctx.bounds.bottom, ctx.view.dirty().bottom);
+      for (; i != _rows.end(); ++i)
+      {
+         i->draw({ x, y }, cnv);
          y += line_height;
-         if (y > ctx.bounds.bottom + metrics.ascent)
+         if (y > bottom + metrics.ascent)
             break;
       }
    }
 
+   void static_text_box::idle(basic_context const& ctx)
+   {
+      if (!_loader)
+         return;
+
+      auto  num_blocks = _blocks.size();
+      _loader->poll(_blocks);
+
+      if (_loader->done())
+      {
+         // The blocks that came in since the poll above
+         _loader->poll(_blocks);
+
+         bool joined = false;
+         if (!_loader->failed())
+         {
+            auto scale = _layout.scale();
+            _text = std::move(_loader->text());
+            _layout = std::move(_loader->glyphs());
+
+            // Short text lives inside the string itself and does not keep
+            // its address when moved.
+            if (_layout.begin() != _text.data())
+               _layout.rebind(_text.data(), _text.data() + _text.size());
+            joined = _layout.scale() == scale;
+            _layout.scale(scale);
+         }
+         _rows.clear();
+         if (_current_size.x > 0 && !(joined && splice_rows(_current_size.x)))
+         {
+            _rows.clear();
+            _layout.break_lines(_current_size.x, _rows);
+         }
+         _blocks.clear();
+         _loader.reset();
+      }
+      else
+      {
+         ctx.view.request_idle();   // More to come
+         if (_current_size.x > 0)
+         {
+            for (auto i = num_blocks; i != _blocks.size(); ++i)
+               add_rows(*_blocks[i], _current_size.x);
+         }
+      }
+
+      if (num_blocks == _blocks.size() && _loader)
+         return;
+      ++_layout_count;
+
+      // The scroll extent grows as rows come in
+      auto  size = _layout.metrics();
+      _current_size.y = _rows.size() * (size.ascent + size.descent + size.leading);
+      ctx.view.refresh();
+   }
+
+   void static_text_box::add_rows(text_loader::block& block, float width)
+   {
+      if (block.glyphs.scale() != _layout.scale())
+      {
+         block.glyphs.scale(_layout.scale());
+         block.width = -1;
+      }
+
+      if (block.width != width)
+      {
+         block.rows.clear();
+         block.glyphs.break_lines(width, block.rows);
+         block.width = width;
+      }
+      _rows.insert(_rows.end(), block.rows.begin(), block.rows.end());
+   }
+
+   bool static_text_box::splice_rows(float width)
+   {
+      // The joined glyphs are the blocks' glyphs, one after the other, so
+      // the rows already broken from the blocks are moved onto them rather
+      // than breaking the whole text again. Not if a block was shaped again
+      // at another scale since.
+      for (auto const& block : _blocks)
+      {
+         if (block->glyphs.scale() != _layout.scale())
+            return false;
+      }
+
+      master_glyphs::part_offset offset;
+      for (auto const& block : _blocks)
+      {
+         if (block->width != width)
+         {
+            block->rows.clear();
+            block->glyphs.break_lines(width, block->rows);
+            block->width = width;
+         }
+         _layout.adopt_rows(block->glyphs, block->rows, offset);
+         _rows.insert(_rows.end(), block->rows.begin(), block->rows.end());
+      }
+      return offset.text == std::ptrdiff_t(_text.size());
+   }
+
    void static_text_box::text(std::string const& text)
    {
+      _loader.reset();
+      _blocks.clear();
       _text = text;
       _rows.clear();
+      ++_layout_count;
       _layout.text(_text.data(), _text.data() + _text.size());
       _layout.break_lines(_current_size.x, _rows);
    }
 
+   void static_text_box::load(char const* path)
+   {
+      _loader.reset();
+      _blocks.clear();
+      _text.clear();
+      _rows.clear();
+      ++_layout_count;
+      _layout.text(_text.data(), _text.data());
+      _loader = std::make_unique<text_loader>(path, _layout);
+      _loader->width(_current_size.x);
+   }
+
    void static_text_box::value(std::string val)
    {
       text(val);
@@ -96,8 +253,21 @@ namespace cycfi { namespace photon
    ////////////////////////////////////////////////////////////////////////////
    // Editable Text Box
    ////////////////////////////////////////////////////////////////////////////
-   basic_text_box::basic_text_box(std::string const& text, char const* face, float size)
-    : static_text_box(text, face, size)
+   basic_text_box::basic_text_box(
+      std::string const& text
+    , char const* face
+    , float size
+    , int style
+   )
+    : static_text_box(text, face, size, get_theme().text_box_font_color, style)
+    , _select_start(-1)
+    , _select_end(-1)
+    , _current_x(0)
+    , _is_focus(false)
+   {}
+
+   basic_text_box::basic_text_box(shaped_text&& text)
+    : static_text_box(std::move(text))
     , _select_start(-1)
     , _select_end(-1)
     , _current_x(0)
@@ -106,6 +276,14 @@ namespace cycfi { namespace photon
 
    void basic_text_box::draw(context const& ctx)
    {
+      // No selection or editing until the whole text is in
+      if (is_loading())
+         return static_text_box::draw(ctx);
+
+      // Idle blinks the caret and takes in pasted text
+      if (_is_focus || _paste)
+         ctx.view.request_idle();
+
       draw_selection(ctx);
       static_text_box::draw(ctx);
       draw_caret(ctx);
@@ -113,7 +291,7 @@ namespace cycfi { namespace photon
 
    element* basic_text_box::click(context const& ctx, mouse_button btn)
    {
-      if (!btn.down) // released? return early
+      if (!btn.down || is_loading()) // released or loading? return early
          return this;
 
       if (_text.empty())
@@ -175,6 +353,9 @@ namespace cycfi { namespace photon
 
    void basic_text_box::drag(context const& ctx, mouse_button btn)
    {
+      if (is_loading())
+         return;
+
       char const* first = &_text[0];
       if (char const* pos = caret_position(ctx, btn.pos))
       {
@@ -197,7 +378,7 @@ namespace cycfi { namespace photon
    namespace
    {
       void add_undo(
-         context const& ctx
+         basic_context const& ctx
        , std::function<void()>& typing_state
        , std::function<void()> undo_f
        , std::function<void()> redo_f
@@ -212,9 +393,100 @@ namespace cycfi { namespace photon
       };
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   // edit_damage: Works out what a key press changed, so that only that is
+   // repainted: the old and new caret (or selection) and, if the text was
+   // edited, the band of rows whose boundaries moved. Rows above the edit
+   // that kept their place, and rows below it that kept their place (if the
+   // number of rows did not change), are left alone.
+   ////////////////////////////////////////////////////////////////////////////
+   struct basic_text_box::edit_damage
+   {
+      struct row_span
+      {
+         int         first;
+         int         last;
+      };
+
+      edit_damage(basic_text_box& box_, context const& ctx)
+       : box(box_)
+       , first(box_._text.data())
+       , size(int(box_._text.size()))
+       , hilite(box_.selection_bounds(ctx))
+      {}
+
+      // Call after the text has changed, but before it is shaped and laid
+      // out again. [start, end) is the replaced range of the old text.
+      void edited(int start, int end)
+      {
+         is_edited = true;
+         edit_start = start;
+         edit_end = end;
+         rows.clear();
+         rows.reserve(box._rows.size());
+         for (auto const& row : box._rows)
+            rows.push_back({ int(row.begin() - first), int(row.end() - first) });
+      }
+
+      // Call after the layout
+      void refresh(context const& ctx)
+      {
+         auto r = max(hilite, box.selection_bounds(ctx));
+         if (is_edited)
+            r = max(r, changed_rows(ctx));
+         if (!r.is_empty())
+            ctx.view.refresh(clip(r, ctx.bounds));
+      }
+
+      rect changed_rows(context const& ctx) const
+      {
+         auto const& after = box._rows;
+         auto  text = box._text.data();
+         int   delta = int(box._text.size()) - size;
+         auto  nb = rows.size();
+         auto  na = after.size();
+
+         auto same = [&](std::size_t i, int shift)
+         {
+            return rows[i].first + shift == int(after[i].begin() - text)
+               && rows[i].last + shift == int(after[i].end() - text);
+         };
+
+         std::size_t i = 0;
+         while (i < nb && i < na && rows[i].last <= edit_start && same(i, 0))
+            ++i;
+
+         std::size_t j = std::max(nb, na);
+         if (nb == na)
+         {
+            while (j > i && rows[j-1].first >= edit_end && same(j-1, delta))
+               --j;
+         }
+
+         if (i == j)
+            return {};
+
+         auto  metrics = box._layout.metrics();
+         auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
+         return {
+            ctx.bounds.left, ctx.bounds.top + i * line_height
+          , ctx.bounds.right, ctx.bounds.top + j * line_height
+         };
+      }
+
+      basic_text_box&         box;
+      char const*             first;
+      int                     size;
+      rect                    hilite;
+      bool                    is_edited = false;
+      int                     edit_start = 0;
+      int                     edit_end = 0;
+      std::vector<row_span>   rows;
+   };
+
    bool basic_text_box::text(context const& ctx, text_info info_)
    {
-      if (_select_start == -1)
+      if (_select_start == -1 || is_loading() || is_pasting())
          return false;
 
       std::string text = codepoint_to_utf8(info_.codepoint);
@@ -222,22 +494,27 @@ namespace cycfi { namespace photon
       if (!_typing_state)
          _typing_state = capture_state();
 
+      edit_damage damage{ *this, ctx };
       if (_select_start == _select_end)
          _text.insert(_select_start, text);
       else
          _text.replace(_select_start, _select_end-_select_start, text);
+      damage.edited(std::min(_select_start, _select_end), std::max(_select_start, _select_end));
       _select_end = ++_select_start;
 
       _layout.text(_text.data(), _text.data() + _text.size());
       layout(ctx);
 
-      scroll_into_view(ctx, true);
+      if (!scroll_caret_into_view(ctx, true))
+         damage.refresh(ctx);
       return true;
    }
 
    bool basic_text_box::key(context const& ctx, key_info k)
    {
       if (_select_start == -1
+         || is_loading()
+         || is_pasting()
          || k.action == key_action::release
          || k.action == key_action::unknown
          )
@@ -246,10 +523,12 @@ namespace cycfi { namespace photon
       bool move_caret = false;
       bool save_x = false;
       bool handled = false;
+      bool text_changed = false;
 
       int start = std::min(_select_end, _select_start);
       int end = std::max(_select_end, _select_start);
       std::function<void()> undo_f = capture_state();
+      edit_damage damage{ *this, ctx };
 
       auto up_down = [this, &ctx, k, &move_caret]()
       {
@@ -324,6 +603,8 @@ namespace cycfi { namespace photon
          case key_code::enter:
             {
                _text.replace(start, end-start, "\n");
+               text_changed = true;
+               damage.edited(start, end);
                _select_start += 1;
                _select_end = _select_start;
                save_x = true;
@@ -336,6 +617,8 @@ namespace cycfi { namespace photon
          case key_code::_delete:
             {
                delete_();
+               text_changed = true;
+               damage.edited(std::min(start, _select_start), end);
                save_x = true;
                add_undo(ctx, _typing_state, undo_f, capture_state());
                handled = true;
@@ -392,6 +675,8 @@ namespace cycfi { namespace photon
             if (k.modifiers & mod_super)
             {
                cut(ctx.view, start, end);
+               text_changed = true;
+               damage.edited(std::min(start, _select_start), end);
                save_x = true;
                add_undo(ctx, _typing_state, undo_f, capture_state());
                handled = true;
@@ -410,8 +695,13 @@ namespace cycfi { namespace photon
             if (k.modifiers & mod_super)
             {
                paste(ctx.view, start, end);
+               if (!is_pasting()) // Otherwise, idle finishes the paste
+               {
+                  text_changed = true;
+                  damage.edited(start, end);
+                  add_undo(ctx, _typing_state, undo_f, capture_state());
+               }
                save_x = true;
-               add_undo(ctx, _typing_state, undo_f, capture_state());
                handled = true;
             }
             break;
@@ -425,10 +715,13 @@ namespace cycfi { namespace photon
                   _typing_state = {}; // reset
                }
 
+               auto size = int(_text.size());
                if (k.modifiers & mod_shift)
                   ctx.view.redo();
                else
                   ctx.view.undo();
+               text_changed = true;
+               damage.edited(0, size);
                handled = true;
             }
             break;
@@ -444,15 +737,14 @@ namespace cycfi { namespace photon
          if (!(k.modifiers & mod_shift))
             _select_start = _select_end;
       }
-      else if (handled)
+      else if (text_changed)
       {
          _layout.text(_text.data(), _text.data() + _text.size());
          layout(ctx);
-         ctx.view.refresh(ctx);
       }
 
-      if (handled)
-         scroll_into_view(ctx, save_x);
+      if (handled && !scroll_caret_into_view(ctx, save_x))
+         damage.refresh(ctx);
       return handled;
    }
 
@@ -466,81 +758,125 @@ namespace cycfi { namespace photon
       if (_select_start == -1)
          return;
 
+      auto const& g = geometry(ctx);
+      if (!_is_focus || !g.has_caret || !_caret_visible)
+         return;
+
       auto& canvas = ctx.canvas;
       auto const& theme = get_theme();
+      auto  width = theme.text_box_caret_width;
+      auto  caret = g.caret.move(ctx.bounds.left, ctx.bounds.top);
+
+      canvas.line_width(width);
+      canvas.stroke_style(theme.text_box_caret_color);
+      canvas.move_to({ caret.left + (width/2), caret.top });
+      canvas.line_to({ caret.left + (width/2), caret.bottom });
+      canvas.stroke();
+   }
 
-      // Handle the case where text is empty
-      if (_is_focus && _text.empty())
-      {
-         auto  size = _layout.metrics();
-         auto  line_height = size.ascent + size.descent + size.leading;
-         auto  width = theme.text_box_caret_width;
-         auto  left = ctx.bounds.left;
-         auto  top = ctx.bounds.top;
+   void basic_text_box::draw_selection(context const& ctx)
+   {
+      if (_select_start == -1)
+         return;
+
+      auto const& g = geometry(ctx);
+      if (!g.has_selection)
+         return;
 
-         canvas.line_width(width);
-         canvas.stroke_style(theme.text_box_caret_color);
-         canvas.move_to({ left + (width/2), top });
-         canvas.line_to({ left + (width/2), top + line_height });
-         canvas.stroke();
+      auto& canvas = ctx.canvas;
+      auto const& theme = get_theme();
+      auto  r1 = g.first_row.move(ctx.bounds.left, ctx.bounds.top);
+      auto  r2 = g.last_row.move(ctx.bounds.left, ctx.bounds.top);
+
+      auto color = theme.text_box_hilite_color;
+      if (!_is_focus)
+         color = color.opacity(0.15);
+      canvas.fill_style(color);
+      if (r1.top == r2.top)
+      {
+         canvas.fill_rect({ r1.left, r1.top, r2.right, r1.bottom });
       }
-      // Draw the caret
-      else if (_is_focus && (_select_start != -1) && (_select_start == _select_end))
+      else
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
-         auto width = theme.text_box_caret_width;
-         rect& caret = start_info.bounds;
-
-         canvas.line_width(width);
-         canvas.stroke_style(theme.text_box_caret_color);
-         canvas.move_to({ caret.left + (width/2), caret.top });
-         canvas.line_to({ caret.left + (width/2), caret.bottom });
-         canvas.stroke();
+         canvas.begin_path();
+         canvas.move_to(r1.top_left());
+         canvas.line_to(r1.top_right());
+         canvas.line_to({ r1.right, r2.top });
+         canvas.line_to(r2.top_right());
+         canvas.line_to(r2.bottom_right());
+         canvas.line_to(r2.bottom_left());
+         canvas.line_to({ r2.left, r1.bottom });
+         canvas.line_to(r1.bottom_left());
+         canvas.close_path();
+         canvas.fill();
       }
    }
 
-   void basic_text_box::draw_selection(context const& ctx)
+   basic_text_box::selection_geometry const& basic_text_box::geometry(context const& ctx)
    {
+      _origin = ctx.bounds.top_left();
+      if (is_geometry_current() && _geometry.width == ctx.bounds.width())
+         return _geometry;
+
+      auto& g = _geometry;
+      g.select_start = _select_start;
+      g.select_end = _select_end;
+      g.layout_count = _layout_count;
+      g.width = ctx.bounds.width();
+      g.has_caret = false;
+      g.has_selection = false;
+
+      // The caret shows right away when it moves
+      _caret_visible = true;
+      _caret_time = clock::now();
+
       if (_select_start == -1)
-         return;
+         return g;
 
-      auto& canvas = ctx.canvas;
-      auto const& theme = get_theme();
+      auto  origin = ctx.bounds.top_left();
+      auto  relative = [origin](rect r) { return r.move(-origin.x, -origin.y); };
 
-      if (!_text.empty())
+      // Handle the case where text is empty
+      if (_text.empty())
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
-         rect& r1 = start_info.bounds;
-         r1.right = ctx.bounds.right;
+         auto  size = _layout.metrics();
+         g.caret = { 0, 0, 0, size.ascent + size.descent + size.leading };
+         g.has_caret = true;
+         return g;
+      }
 
-         auto  end_info = glyph_info(ctx, _text.data() + _select_end);
-         rect& r2 = end_info.bounds;
-         r2.right = r2.left;
-         r2.left = ctx.bounds.left;
+      auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+      if (!start_info.str)
+         return g;
 
-         auto color = theme.text_box_hilite_color;
-         if (!_is_focus)
-            color = color.opacity(0.15);
-         canvas.fill_style(color);
-         if (r1.top == r2.top)
-         {
-            canvas.fill_rect({ r1.left, r1.top, r2.right, r1.bottom });
-         }
-         else
-         {
-            canvas.begin_path();
-            canvas.move_to(r1.top_left());
-            canvas.line_to(r1.top_right());
-            canvas.line_to({ r1.right, r2.top });
-            canvas.line_to(r2.top_right());
-            canvas.line_to(r2.bottom_right());
-            canvas.line_to(r2.bottom_left());
-            canvas.line_to({ r2.left, r1.bottom });
-            canvas.line_to(r1.bottom_left());
-            canvas.close_path();
-            canvas.fill();
-         }
+      if (_select_start == _select_end)
+      {
+         g.caret = relative(start_info.bounds);
+         g.has_caret = true;
+         return g;
       }
+
+      auto  end_info = glyph_info(ctx, _text.data() + _select_end);
+      if (!end_info.str)
+         return g;
+
+      rect& r1 = start_info.bounds;
+      r1.right = ctx.bounds.right;
+      rect& r2 = end_info.bounds;
+      r2.right = r2.left;
+      r2.left = ctx.bounds.left;
+
+      g.first_row = relative(r1);
+      g.last_row = relative(r2);
+      g.has_selection = true;
+      return g;
+   }
+
+   bool basic_text_box::is_geometry_current() const
+   {
+      return _geometry.select_start == _select_start
+         && _geometry.select_end == _select_end
+         && _geometry.layout_count == _layout_count;
    }
 
    char const* basic_text_box::caret_position(context const& ctx, point p)
@@ -550,39 +886,21 @@ namespace cycfi { namespace photon
       auto  metrics = _layout.metrics();
       auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
 
-      char const* found = nullptr;
-      for (auto& row : _rows)
-      {
-         // Check if p is within this row
-         if ((p.y >= y) && (p.y < y + line_height))
-         {
-            // Check if we are at the very start of the row
-            if (p.x == x)
-            {
-               found = row.begin();
-               break;
-            }
-
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [p, x, &found](char const* utf8, float left, float right)
-               {
-                  if ((p.x >= (x + left)) && (p.x < (x + right)))
-                  {
-                     found = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            // Assume it's at the end of the row if we haven't found a hit
-            if (!found)
-               found = row.end();
-            break;
-         }
-         y += line_height;
-      }
-      return found;
+      // Rows all have the same height
+      if (p.y < y || line_height <= 0)
+         return nullptr;
+      auto  index = std::size_t((p.y - y) / line_height);
+      if (index >= _rows.size())
+         return nullptr;
+      auto const& row = _rows[index];
+
+      // Check if we are at the very start of the row
+      if (p.x == x)
+         return row.begin();
+
+      // Assume it's at the end of the row if we haven't found a hit
+      auto  glyph = row.glyph_at(p.x - x);
+      return glyph.utf8 ? glyph.utf8 : row.end();
    }
 
    basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, char const* s)
@@ -612,43 +930,38 @@ namespace cycfi { namespace photon
          return info;
       }
 
-      glyphs*  prev_row = nullptr;
-      for (auto& row : _rows)
+      // Find the last row starting at or before s
+      auto  i = std::upper_bound(_rows.begin(), _rows.end(), s,
+         [](char const* s, glyphs const& row) { return s < row.begin(); });
+
+      // Check if s is within this row
+      if (i != _rows.begin() && s < std::prev(i)->end())
       {
-         // Check if s is within this row
-         if (s >= row.begin() && s < row.end())
-         {
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [s, &info, x, y, ascent, descent](char const* utf8, float left, float right)
-               {
-                  if (utf8 >= s)
-                  {
-                     info.pos = { x + left, y };
-                     info.bounds = { x + left, y - ascent, x + right, y + descent };
-                     info.str = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            break;
-         }
-         // This handles the case where s is in between the start of the
-         // current row and the end of the previous.
-         else if (s < row.begin() && prev_row)
+         auto const& row = *std::prev(i);
+         auto  row_y = y + line_height * (i - _rows.begin() - 1);
+
+         // Get the actual coordinates of the glyph
+         auto  glyph = row.glyph_of(s);
+         if (glyph.utf8)
          {
-            auto  rightmost = x + prev_row->width();
-            auto  prev_y = y - line_height;
-            info.pos = { rightmost, prev_y };
-            info.bounds = { rightmost, prev_y - ascent, rightmost + 10, prev_y + descent };
-            info.str = s;
-            break;
+            info.pos = { x + glyph.left, row_y };
+            info.bounds = { x + glyph.left, row_y - ascent, x + glyph.right, row_y + descent };
+            info.str = glyph.utf8;
          }
-         y += line_height;
-         prev_row = &row;
+         return info;
       }
 
+      // This handles the case where s is in between the end of a row and
+      // the start of the next.
+      auto  prev = (i == _rows.begin()) ? i : std::prev(i);
+      if (i != _rows.end() && std::next(prev) != _rows.end())
+      {
+         auto  rightmost = x + prev->width();
+         auto  prev_y = y + line_height * (prev - _rows.begin());
+         info.pos = { rightmost, prev_y };
+         info.bounds = { rightmost, prev_y - ascent, rightmost + 10, prev_y + descent };
+         info.str = s;
+      }
       return info;
    }
 
@@ -683,7 +996,7 @@ namespace cycfi { namespace photon
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_text.data() + start_, _text.data() + end_);
          delete_();
       }
    }
@@ -694,21 +1007,143 @@ namespace cycfi { namespace photon
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_text.data() + start_, _text.data() + end_);
       }
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   // paste_state: Pasted text on its way in. The clipboard text arrives
+   // asynchronously. It is then shaped a chunk at a time, one chunk per idle
+   // call, so that a big paste does not stall the UI. When all of it is
+   // shaped, it is inserted in one go, without shaping the rest of the text
+   // again.
+   ////////////////////////////////////////////////////////////////////////////
+   struct basic_text_box::paste_state
+   {
+      static constexpr std::size_t chunk_size = 64 * 1024;
+
+      std::string                text;
+      bool                       ready = false; // The text has arrived
+      int                        start;         // The selection it replaces
+      int                        end;
+      std::size_t                shaped = 0;    // Bytes shaped so far
+      std::vector<master_glyphs> parts;
+      state_saver_f              undo_f;
+   };
+
    void basic_text_box::paste(view& v, int start, int end)
    {
-      if (start != -1)
+      if (start != -1 && !_paste)
       {
-         auto  end_ = std::max(start, end);
-         auto  start_ = std::min(start, end);
-         std::string ins = clipboard();
-         _text.replace(start, end_-start_, ins);
-         start += ins.size();
-         _select_end = _select_start = start;
+         auto  paste_ = std::make_shared<paste_state>();
+         paste_->start = std::min(start, end);
+         paste_->end = std::max(start, end);
+         paste_->undo_f = capture_state();
+         _paste = paste_;
+         v.request_idle();
+
+         // We may be gone by the time the text arrives
+         request_clipboard(
+            [p = std::weak_ptr<paste_state>(paste_)](std::string text)
+            {
+               if (auto paste_ = p.lock())
+               {
+                  paste_->text = std::move(text);
+                  paste_->ready = true;
+               }
+            }
+         );
+      }
+   }
+
+   void basic_text_box::filter_paste(std::string& text) const
+   {
+   }
+
+   void basic_text_box::idle(basic_context const& ctx)
+   {
+      static_text_box::idle(ctx);
+      if (_is_focus || _paste)
+         ctx.view.request_idle();
+
+      // Blink the caret. Only the caret is repainted.
+      constexpr auto blink_period = std::chrono::milliseconds(500);
+      if (_is_focus && _geometry.has_caret && is_geometry_current())
+      {
+         auto  now = clock::now();
+         if (now - _caret_time >= blink_period)
+         {
+            _caret_visible = !_caret_visible;
+            _caret_time = now;
+            auto  width = get_theme().text_box_caret_width;
+            auto  caret = _geometry.caret;
+            caret.right = caret.left + width;
+            ctx.view.refresh(caret.move(_origin.x, _origin.y).inset(-1, -1));
+         }
+      }
+
+      if (!_paste || !_paste->ready || is_loading())
+         return;
+
+      auto& p = *_paste;
+      if (p.parts.empty() && p.shaped == 0)
+      {
+         filter_paste(p.text);
+         if (p.text.empty())
+         {
+            _paste.reset();
+            return;
+         }
+      }
+
+      auto  first = p.text.data();
+      auto  last = first + p.text.size();
+
+      // Shape the next chunk, ending at a codepoint boundary
+      if (p.parts.empty() || p.shaped != p.text.size())
+      {
+         auto  i = first + p.shaped;
+         auto  j = last;
+         if (std::size_t(j - i) > paste_state::chunk_size)
+         {
+            j = i + paste_state::chunk_size;
+            while ((uint8_t(*j) & 0xC0) == 0x80)
+               --j;
+         }
+         p.parts.emplace_back(i, j, _layout);
+         p.shaped = j - first;
+         if (p.shaped != p.text.size())
+            return;
+      }
+
+      auto  paste_ = std::move(_paste);
+
+      // Give up if the text was changed under us
+      if (p.end > int(_text.size()))
+         return;
+
+      std::vector<master_glyphs const*> parts;
+      for (auto const& part : p.parts)
+         parts.push_back(&part);
+      master_glyphs ins{ first, last, parts };
+
+      _text.replace(p.start, p.end - p.start, p.text);
+      _layout.replace(
+         _text.data(), _text.data() + _text.size()
+       , p.start, p.end - p.start, ins
+      );
+      _select_end = _select_start = p.start + int(p.text.size());
+      add_undo(ctx, _typing_state, p.undo_f, capture_state());
+      ++_layout_count;
+
+      if (_current_size.x > 0)
+      {
+         _rows.clear();
+         _layout.break_lines(_current_size.x, _rows);
+         auto  metrics = _layout.metrics();
+         _current_size.y = _rows.size() * (metrics.ascent + metrics.descent + metrics.leading);
       }
+      ctx.view.refresh();
    }
 
    struct basic_text_box::state_saver
@@ -746,24 +1181,56 @@ namespace cycfi { namespace photon
 
    void basic_text_box::scroll_into_view(context const& ctx, bool save_x)
    {
-      if (_text.empty())
-      {
-         ctx.view.refresh(ctx);
+      if (!_text.empty() && _select_end == -1)
          return;
-      }
 
-      if (_select_end == -1)
-         return;
+      if (!scroll_caret_into_view(ctx, save_x))
+         ctx.view.refresh(ctx);
+   }
+
+   // Returns true if we had to scroll, which repaints everything anyway.
+   bool basic_text_box::scroll_caret_into_view(context const& ctx, bool save_x)
+   {
+      if (_text.empty() || _select_end == -1)
+         return false;
 
       auto info = glyph_info(ctx, &_text[_select_end]);
-      if (info.str)
-      {
-         if (!scrollable::find(ctx).scroll_into_view(info.bounds.inset(-15, 0)))
-            ctx.view.refresh(ctx);
+      if (!info.str)
+         return false;
 
-         if (save_x)
-            _current_x = info.pos.x - ctx.bounds.left;
+      if (save_x)
+         _current_x = info.pos.x - ctx.bounds.left;
+      return scrollable::find(ctx).scroll_into_view(info.bounds.inset(-15, 0));
+   }
+
+   // The area covered by the caret or the selection
+   rect basic_text_box::selection_bounds(context const& ctx)
+   {
+      if (_select_start == -1)
+         return {};
+
+      auto  metrics = _layout.metrics();
+      auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
+      auto  pad = get_theme().text_box_caret_width + 1;
+
+      if (_text.empty())
+      {
+         auto  left = ctx.bounds.left;
+         auto  top = ctx.bounds.top;
+         return { left, top, left + pad, top + line_height };
       }
+
+      auto  start = std::min(_select_start, _select_end);
+      auto  end = std::max(_select_start, _select_end);
+      auto  first = glyph_info(ctx, _text.data() + start);
+      auto  last = (start == end) ? first : glyph_info(ctx, _text.data() + end);
+      if (!first.str || !last.str)
+         return ctx.bounds;
+
+      // A selection over more than one row spans the full width
+      if (first.bounds.top != last.bounds.top)
+         return { ctx.bounds.left, first.bounds.top, ctx.bounds.right, last.bounds.bottom };
+      return max(first.bounds, last.bounds).inset(-pad, 0);
    }
 
    bool basic_text_box::focus(focus_request r)
@@ -807,10 +1274,67 @@ namespace cycfi { namespace photon
       _select_start = _select_end = -1;
    }
 
+   void basic_text_box::load(char const* path)
+   {
+      select_none();
+      static_text_box::load(path);
+   }
+
+   namespace
+   {
+      bool is_word(word_break_class wb)
+      {
+         using w = word_break_class;
+         switch (wb)
+         {
+            case w::aletter: case w::hebrew_letter: case w::numeric:
+            case w::katakana: case w::extendnumlet:
+            case w::extend: case w::format: case w::zwj:
+               return true;
+            default:
+               return false;
+         }
+      }
+
+      bool is_letter(word_break_class wb)
+      {
+         return wb == word_break_class::aletter
+            || wb == word_break_class::hebrew_letter;
+      }
+   }
+
+   // A simplified UAX #29: letters, digits, connectors such as '_' and
+   // their combining marks make up words (WB4, WB5, WB8-10, WB13). A
+   // MidLetter between two letters ("can't") or a MidNum between two
+   // digits ("3.14") does not break the word either (WB6-7, WB11-12).
    bool basic_text_box::word_break(char const* utf8) const
    {
-      auto cp = codepoint(utf8);
-      return is_space(cp) || is_punctuation(cp);
+      using w = word_break_class;
+
+      char const* p = utf8;
+      auto wb = word_break_of(codepoint(p));
+      if (is_word(wb))
+         return false;
+
+      bool mid_letter = wb == w::midletter || wb == w::midnumlet || wb == w::single_quote;
+      bool mid_num = wb == w::midnum || wb == w::midnumlet || wb == w::single_quote;
+      if (!mid_letter && !mid_num)
+         return true;
+
+      char const* first = _text.data();
+      char const* last = first + _text.size();
+      if (utf8 == first || p == last)
+         return true;
+
+      char const* q = prev_utf8(first, utf8);
+      auto before = word_break_of(codepoint(q));
+      auto after = word_break_of(codepoint(p));
+
+      if (mid_letter && is_letter(before) && is_letter(after))
+         return false;
+      if (mid_num && before == w::numeric && after == w::numeric)
+         return false;
+      return true;
    }
 
    bool basic_text_box::line_break(char const* utf8) const
@@ -893,35 +1417,15 @@ namespace cycfi { namespace photon
       return basic_text_box::key(ctx, k);
    }
 
-   void basic_input_box::paste(view& v, int start, int end)
+   void basic_input_box::filter_paste(std::string& text) const
    {
-      if (start != -1)
-      {
-         auto  end_ = std::max(start, end);
-         auto  start_ = std::min(start, end);
-
-         std::string clip = clipboard();
-         if (clip.empty())
-            return;
-
-         std::string ins;
-
-         // Copy clip ito ins, stop when a newline is found.
-         // Also, limit ins to 256 characters.
-         char const* p = &clip[0];
-         char const* last = p + clip.size();
-
-         for (int i = 0; (i < 256) && (p != last); ++p, ++i)
-         {
-            if (is_newline(uint8_t(*p)))
-               break;
-            ins += *p;
-         }
-
-         _text.replace(start_, end_-start_, ins);
-         start_ += ins.size();
-         select_start(start_);
-         select_end(start_);
-      }
+      // Keep the first line, up to 256 bytes, ending at a codepoint
+      // boundary
+      std::size_t n = 0;
+      while (n != text.size() && n != 256 && !is_newline(uint8_t(text[n])))
+         ++n;
+      while (n != 0 && n != text.size() && (uint8_t(text[n]) & 0xC0) == 0x80)
+         --n;
+      text.resize(n);
    }
 }}
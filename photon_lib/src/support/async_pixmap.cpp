@@ -0,0 +1,162 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/async_pixmap.hpp>
+#include <photon/support/pixmap_registry.hpp>
+#include <photon/support/thread_pool.hpp>
+#include <photon/support/detail/stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace cycfi { namespace photon
+{
+   struct async_pixmap::state
+   {
+      enum status_enum { waiting, loaded, failed };
+
+      std::string                filename;
+      float                      scale;
+      pixmap_ptr                 pixmap;
+      std::atomic<int>           status{ waiting };
+   };
+
+   namespace
+   {
+      using state_ptr = std::shared_ptr<async_pixmap::state>;
+      using state_weak_ptr = std::weak_ptr<async_pixmap::state>;
+
+      // The size in pixels, from the PNG header. stb_image is built without
+      // PNG support; PNGs are decoded by cairo.
+      bool png_size(char const* filename, int& w, int& h)
+      {
+         unsigned char header[24];
+         auto file = std::fopen(filename, "rb");
+         if (!file)
+            return false;
+         auto n = std::fread(header, 1, sizeof(header), file);
+         std::fclose(file);
+
+         unsigned char const signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+         if (n != sizeof(header) || std::memcmp(header, signature, 8) != 0)
+            return false;
+
+         auto be32 = [&](int i)
+         {
+            return int(
+               (unsigned(header[i]) << 24) | (unsigned(header[i+1]) << 16)
+             | (unsigned(header[i+2]) << 8) | unsigned(header[i+3]));
+         };
+         w = be32(16);
+         h = be32(20);
+         return true;
+      }
+
+      // Decodes images on a thread_pool. Each job posted to the pool takes
+      // the most urgent image left in the queues, not necessarily the one
+      // that posted it.
+      class loader
+      {
+      public:
+
+         void add(state_ptr const& s)
+         {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _pending.push_back(s);
+            }
+            _pool.post([this]{ load_next(); });
+         }
+
+         void prioritize(state_ptr const& s)
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto i = std::find_if(_pending.begin(), _pending.end(),
+               [&](state_weak_ptr const& w) { return w.lock() == s; });
+            if (i != _pending.end())
+            {
+               _pending.erase(i);
+               _urgent.push_back(s);
+            }
+         }
+
+      private:
+
+         void load_next()
+         {
+            state_ptr s;
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               auto& queue = _urgent.empty() ? _pending : _urgent;
+               if (queue.empty())
+                  return;
+               s = queue.front().lock();
+               queue.pop_front();
+            }
+
+            // Dropped before we got to it
+            if (!s)
+               return;
+
+            try
+            {
+               s->pixmap = get_pixmap_registry().get(s->filename.c_str(), s->scale);
+               s->status = async_pixmap::state::loaded;
+            }
+            catch (...)
+            {
+               s->status = async_pixmap::state::failed;
+            }
+         }
+
+         std::mutex                 _mutex;
+         std::deque<state_weak_ptr> _urgent;
+         std::deque<state_weak_ptr> _pending;
+         thread_pool                _pool;
+      };
+
+      loader& get_loader()
+      {
+         static loader loader_;
+         return loader_;
+      }
+   }
+
+   async_pixmap::async_pixmap(char const* filename, float scale)
+    : _state(std::make_shared<state>())
+   {
+      int w, h, components;
+      if (!png_size(filename, w, h) && !stbi_info(filename, &w, &h, &components))
+         throw failed_to_load_pixmap{ "Failed to load pixmap." };
+
+      _size = { w * scale, h * scale };
+      _state->filename = filename;
+      _state->scale = scale;
+      get_loader().add(_state);
+   }
+
+   bool async_pixmap::ready() const
+   {
+      return _state->status != state::waiting;
+   }
+
+   pixmap_ptr async_pixmap::get() const
+   {
+      // The status is stored after the pixmap, and read before it
+      if (_state->status != state::loaded)
+         return {};
+      return _state->pixmap;
+   }
+
+   void async_pixmap::prioritize()
+   {
+      if (!ready())
+         get_loader().prioritize(_state);
+   }
+}}
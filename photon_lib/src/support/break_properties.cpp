@@ -0,0 +1,731 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/text_utils.hpp>
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      using lb = line_break_class;
+      using wb = word_break_class;
+
+      template <typename T>
+      struct property_range
+      {
+         uint32_t    first;
+         uint32_t    last;
+         T           value;
+      };
+
+      struct codepoint_range
+      {
+         uint32_t    first;
+         uint32_t    last;
+      };
+
+      /////////////////////////////////////////////////////////////////////////
+      // Property data, from the Unicode LineBreak.txt and WordBreakProperty.txt
+      // files. This is a subset: it covers the scripts and the punctuation,
+      // symbol and CJK blocks we care about, and ranges are merged where the
+      // exact assignment does not affect breaking. Codepoints not listed are
+      // AL (line break) and Other (word break).
+      //
+      // Later entries override earlier ones, so broad blocks come first and
+      // exceptions within them follow.
+      /////////////////////////////////////////////////////////////////////////
+      constexpr property_range<lb> line_break_ranges[] =
+      {
+         // Ideographic and other wide scripts
+         { 0x2E80, 0x2FFF, lb::id },   { 0x3000, 0x303F, lb::id },
+         { 0x3040, 0x309F, lb::id },   { 0x30A0, 0x30FF, lb::id },
+         { 0x3100, 0x31FF, lb::id },   { 0x3200, 0x4DBF, lb::id },
+         { 0x4E00, 0x9FFF, lb::id },   { 0xA000, 0xA4CF, lb::id },
+         { 0xF900, 0xFAFF, lb::id },   { 0xFE30, 0xFE4F, lb::id },
+         { 0xFF01, 0xFF60, lb::id },   { 0x1F000, 0x1FAFF, lb::id },
+
+         // Hangul. The syllables are H3 here; break_properties tells the H2
+         // (LV) syllables, every 28th, apart.
+         { 0x1100, 0x115F, lb::jl },   { 0x1160, 0x11A7, lb::jv },
+         { 0x11A8, 0x11FF, lb::jt },   { 0xA960, 0xA97C, lb::jl },
+         { 0xAC00, 0xD7A3, lb::h3 },   { 0xD7B0, 0xD7C6, lb::jv },
+         { 0xD7CB, 0xD7FB, lb::jt },
+
+         // Complex context (Southeast Asian) scripts
+         { 0x0E00, 0x0EFF, lb::sa },   { 0x1000, 0x109F, lb::sa },
+         { 0x1780, 0x17FF, lb::sa },   { 0x1950, 0x19DF, lb::sa },
+
+         // Hebrew letters
+         { 0x05D0, 0x05EA, lb::hl },   { 0x05EF, 0x05F2, lb::hl },
+         { 0xFB1D, 0xFB1D, lb::hl },   { 0xFB1F, 0xFB28, lb::hl },
+         { 0xFB2A, 0xFB4F, lb::hl },
+
+         // Surrogates
+         { 0xD800, 0xDFFF, lb::sg },
+
+         // Combining marks and controls
+         { 0x0000, 0x0008, lb::cm },   { 0x000E, 0x001F, lb::cm },
+         { 0x007F, 0x0084, lb::cm },   { 0x0086, 0x009F, lb::cm },
+         { 0x0300, 0x034E, lb::cm },   { 0x0350, 0x036F, lb::cm },
+         { 0x0483, 0x0489, lb::cm },   { 0x0591, 0x05BD, lb::cm },
+         { 0x05BF, 0x05BF, lb::cm },   { 0x05C1, 0x05C2, lb::cm },
+         { 0x05C4, 0x05C5, lb::cm },   { 0x05C7, 0x05C7, lb::cm },
+         { 0x0610, 0x061A, lb::cm },   { 0x064B, 0x065F, lb::cm },
+         { 0x0670, 0x0670, lb::cm },   { 0x06D6, 0x06DC, lb::cm },
+         { 0x06DF, 0x06E4, lb::cm },   { 0x06E7, 0x06E8, lb::cm },
+         { 0x06EA, 0x06ED, lb::cm },   { 0x0900, 0x0903, lb::cm },
+         { 0x093A, 0x093C, lb::cm },   { 0x093E, 0x094F, lb::cm },
+         { 0x0951, 0x0957, lb::cm },   { 0x0962, 0x0963, lb::cm },
+         { 0x1AB0, 0x1AFF, lb::cm },   { 0x1DC0, 0x1DFF, lb::cm },
+         { 0x200C, 0x200C, lb::cm },   { 0x200E, 0x200F, lb::cm },
+         { 0x202A, 0x202E, lb::cm },   { 0x2066, 0x206F, lb::cm },
+         { 0x20D0, 0x20F0, lb::cm },   { 0x302A, 0x302F, lb::cm },
+         { 0x3099, 0x309A, lb::cm },   { 0xFE00, 0xFE0F, lb::cm },
+         { 0xFE20, 0xFE2F, lb::cm },   { 0xFFF9, 0xFFFB, lb::cm },
+         { 0x200D, 0x200D, lb::zwj },
+
+         // Mandatory breaks, spaces and glue
+         { 0x000A, 0x000A, lb::lf },   { 0x000B, 0x000C, lb::bk },
+         { 0x000D, 0x000D, lb::cr },   { 0x0085, 0x0085, lb::nl },
+         { 0x2028, 0x2029, lb::bk },   { 0x0020, 0x0020, lb::sp },
+         { 0x200B, 0x200B, lb::zw },   { 0x2060, 0x2060, lb::wj },
+         { 0xFEFF, 0xFEFF, lb::wj },   { 0x00A0, 0x00A0, lb::gl },
+         { 0x034F, 0x034F, lb::gl },   { 0x0F08, 0x0F08, lb::gl },
+         { 0x0F0C, 0x0F0C, lb::gl },   { 0x0F12, 0x0F12, lb::gl },
+         { 0x2007, 0x2007, lb::gl },   { 0x2011, 0x2011, lb::gl },
+         { 0x202F, 0x202F, lb::gl },
+
+         // Break after
+         { 0x0009, 0x0009, lb::ba },   { 0x007C, 0x007C, lb::ba },
+         { 0x00AD, 0x00AD, lb::ba },   { 0x058A, 0x058A, lb::ba },
+         { 0x05BE, 0x05BE, lb::ba },   { 0x0964, 0x0965, lb::ba },
+         { 0x0E5A, 0x0E5B, lb::ba },   { 0x1680, 0x1680, lb::ba },
+         { 0x2000, 0x2006, lb::ba },   { 0x2008, 0x200A, lb::ba },
+         { 0x2010, 0x2010, lb::ba },   { 0x2012, 0x2013, lb::ba },
+         { 0x2027, 0x2027, lb::ba },   { 0x2056, 0x2056, lb::ba },
+         { 0x2058, 0x205B, lb::ba },   { 0x205D, 0x205F, lb::ba },
+         { 0x2CFA, 0x2CFC, lb::ba },   { 0x2CFF, 0x2CFF, lb::ba },
+         { 0x2E0E, 0x2E15, lb::ba },   { 0x2E17, 0x2E17, lb::ba },
+         { 0x2E1A, 0x2E1B, lb::ba },   { 0x2E1E, 0x2E1F, lb::ba },
+         { 0x2E2A, 0x2E2D, lb::ba },   { 0x2E30, 0x2E31, lb::ba },
+         { 0x2E33, 0x2E34, lb::ba },   { 0x2E3C, 0x2E3E, lb::ba },
+         { 0x2E40, 0x2E41, lb::ba },   { 0x2E43, 0x2E4A, lb::ba },
+
+         // Break before, both sides, hyphens
+         { 0x00B4, 0x00B4, lb::bb },   { 0x02C8, 0x02C8, lb::bb },
+         { 0x02CC, 0x02CC, lb::bb },   { 0x02DF, 0x02DF, lb::bb },
+         { 0x0F01, 0x0F04, lb::bb },   { 0x1806, 0x1806, lb::bb },
+         { 0x1FFD, 0x1FFD, lb::bb },   { 0xA874, 0xA875, lb::bb },
+         { 0x2014, 0x2014, lb::b2 },   { 0x2E3A, 0x2E3B, lb::b2 },
+         { 0x002D, 0x002D, lb::hy },   { 0xFFFC, 0xFFFC, lb::cb },
+
+         // Opening and closing punctuation
+         { 0x0028, 0x0028, lb::op },   { 0x005B, 0x005B, lb::op },
+         { 0x007B, 0x007B, lb::op },   { 0x00A1, 0x00A1, lb::op },
+         { 0x00BF, 0x00BF, lb::op },   { 0x0F3A, 0x0F3A, lb::op },
+         { 0x0F3C, 0x0F3C, lb::op },   { 0x169B, 0x169B, lb::op },
+         { 0x201A, 0x201A, lb::op },   { 0x201E, 0x201E, lb::op },
+         { 0x2045, 0x2045, lb::op },   { 0x207D, 0x207D, lb::op },
+         { 0x208D, 0x208D, lb::op },   { 0x2308, 0x2308, lb::op },
+         { 0x230A, 0x230A, lb::op },   { 0x2329, 0x2329, lb::op },
+         { 0x2768, 0x2768, lb::op },   { 0x276A, 0x276A, lb::op },
+         { 0x276C, 0x276C, lb::op },   { 0x276E, 0x276E, lb::op },
+         { 0x2770, 0x2770, lb::op },   { 0x2772, 0x2772, lb::op },
+         { 0x2774, 0x2774, lb::op },   { 0x27C5, 0x27C5, lb::op },
+         { 0x27E6, 0x27E6, lb::op },   { 0x27E8, 0x27E8, lb::op },
+         { 0x27EA, 0x27EA, lb::op },   { 0x27EC, 0x27EC, lb::op },
+         { 0x27EE, 0x27EE, lb::op },   { 0x2983, 0x2983, lb::op },
+         { 0x3008, 0x3008, lb::op },   { 0x300A, 0x300A, lb::op },
+         { 0x300C, 0x300C, lb::op },   { 0x300E, 0x300E, lb::op },
+         { 0x3010, 0x3010, lb::op },   { 0x3014, 0x3014, lb::op },
+         { 0x3016, 0x3016, lb::op },   { 0x3018, 0x3018, lb::op },
+         { 0x301A, 0x301A, lb::op },   { 0x301D, 0x301D, lb::op },
+         { 0xFE17, 0xFE17, lb::op },   { 0xFE35, 0xFE35, lb::op },
+         { 0xFE37, 0xFE37, lb::op },   { 0xFE39, 0xFE39, lb::op },
+         { 0xFE3B, 0xFE3B, lb::op },   { 0xFE3D, 0xFE3D, lb::op },
+         { 0xFE3F, 0xFE3F, lb::op },   { 0xFE41, 0xFE41, lb::op },
+         { 0xFE43, 0xFE43, lb::op },   { 0xFE47, 0xFE47, lb::op },
+         { 0xFE59, 0xFE59, lb::op },   { 0xFE5B, 0xFE5B, lb::op },
+         { 0xFE5D, 0xFE5D, lb::op },   { 0xFF08, 0xFF08, lb::op },
+         { 0xFF3B, 0xFF3B, lb::op },   { 0xFF5B, 0xFF5B, lb::op },
+         { 0xFF5F, 0xFF5F, lb::op },   { 0xFF62, 0xFF62, lb::op },
+
+         { 0x0029, 0x0029, lb::cp },   { 0x005D, 0x005D, lb::cp },
+         { 0x007D, 0x007D, lb::cl },   { 0x0F3B, 0x0F3B, lb::cl },
+         { 0x0F3D, 0x0F3D, lb::cl },   { 0x169C, 0x169C, lb::cl },
+         { 0x2046, 0x2046, lb::cl },   { 0x207E, 0x207E, lb::cl },
+         { 0x208E, 0x208E, lb::cl },   { 0x2309, 0x2309, lb::cl },
+         { 0x230B, 0x230B, lb::cl },   { 0x232A, 0x232A, lb::cl },
+         { 0x2769, 0x2769, lb::cl },   { 0x276B, 0x276B, lb::cl },
+         { 0x276D, 0x276D, lb::cl },   { 0x276F, 0x276F, lb::cl },
+         { 0x2771, 0x2771, lb::cl },   { 0x2773, 0x2773, lb::cl },
+         { 0x2775, 0x2775, lb::cl },   { 0x27C6, 0x27C6, lb::cl },
+         { 0x27E7, 0x27E7, lb::cl },   { 0x27E9, 0x27E9, lb::cl },
+         { 0x27EB, 0x27EB, lb::cl },   { 0x27ED, 0x27ED, lb::cl },
+         { 0x27EF, 0x27EF, lb::cl },   { 0x2984, 0x2984, lb::cl },
+         { 0x3001, 0x3002, lb::cl },   { 0x3009, 0x3009, lb::cl },
+         { 0x300B, 0x300B, lb::cl },   { 0x300D, 0x300D, lb::cl },
+         { 0x300F, 0x300F, lb::cl },   { 0x3011, 0x3011, lb::cl },
+         { 0x3015, 0x3015, lb::cl },   { 0x3017, 0x3017, lb::cl },
+         { 0x3019, 0x3019, lb::cl },   { 0x301B, 0x301B, lb::cl },
+         { 0x301E, 0x301F, lb::cl },   { 0xFE11, 0xFE12, lb::cl },
+         { 0xFE18, 0xFE18, lb::cl },   { 0xFE36, 0xFE36, lb::cl },
+         { 0xFE38, 0xFE38, lb::cl },   { 0xFE3A, 0xFE3A, lb::cl },
+         { 0xFE3C, 0xFE3C, lb::cl },   { 0xFE3E, 0xFE3E, lb::cl },
+         { 0xFE40, 0xFE40, lb::cl },   { 0xFE42, 0xFE42, lb::cl },
+         { 0xFE44, 0xFE44, lb::cl },   { 0xFE48, 0xFE48, lb::cl },
+         { 0xFE50, 0xFE50, lb::cl },   { 0xFE52, 0xFE52, lb::cl },
+         { 0xFE5A, 0xFE5A, lb::cl },   { 0xFE5C, 0xFE5C, lb::cl },
+         { 0xFE5E, 0xFE5E, lb::cl },   { 0xFF09, 0xFF09, lb::cp },
+         { 0xFF0C, 0xFF0C, lb::cl },   { 0xFF0E, 0xFF0E, lb::cl },
+         { 0xFF3D, 0xFF3D, lb::cp },   { 0xFF5D, 0xFF5D, lb::cl },
+         { 0xFF60, 0xFF61, lb::cl },   { 0xFF63, 0xFF64, lb::cl },
+
+         // Quotation marks
+         { 0x0022, 0x0022, lb::qu },   { 0x0027, 0x0027, lb::qu },
+         { 0x00AB, 0x00AB, lb::qu },   { 0x00BB, 0x00BB, lb::qu },
+         { 0x2018, 0x2019, lb::qu },   { 0x201B, 0x201D, lb::qu },
+         { 0x201F, 0x201F, lb::qu },   { 0x2039, 0x203A, lb::qu },
+         { 0x275B, 0x2760, lb::qu },   { 0x2E00, 0x2E0D, lb::qu },
+         { 0x2E1C, 0x2E1D, lb::qu },   { 0x2E20, 0x2E21, lb::qu },
+
+         // Exclamation/interrogation, infix separators, non-starters
+         { 0x0021, 0x0021, lb::ex },   { 0x003F, 0x003F, lb::ex },
+         { 0x05C6, 0x05C6, lb::ex },   { 0x061B, 0x061B, lb::ex },
+         { 0x061E, 0x061F, lb::ex },   { 0x06D4, 0x06D4, lb::ex },
+         { 0x07F9, 0x07F9, lb::ex },   { 0x0F0D, 0x0F11, lb::ex },
+         { 0x0F14, 0x0F14, lb::ex },   { 0x1802, 0x1803, lb::ex },
+         { 0x1808, 0x1809, lb::ex },   { 0x1944, 0x1945, lb::ex },
+         { 0x2762, 0x2763, lb::ex },   { 0x2CF9, 0x2CF9, lb::ex },
+         { 0x2CFE, 0x2CFE, lb::ex },   { 0x2E2E, 0x2E2E, lb::ex },
+         { 0xFE15, 0xFE16, lb::ex },   { 0xFE56, 0xFE57, lb::ex },
+         { 0xFF01, 0xFF01, lb::ex },   { 0xFF1F, 0xFF1F, lb::ex },
+
+         { 0x002C, 0x002C, lb::is },   { 0x002E, 0x002E, lb::is },
+         { 0x003A, 0x003B, lb::is },   { 0x037E, 0x037E, lb::is },
+         { 0x0589, 0x0589, lb::is },   { 0x060C, 0x060D, lb::is },
+         { 0x07F8, 0x07F8, lb::is },   { 0x2044, 0x2044, lb::is },
+         { 0xFE10, 0xFE10, lb::is },   { 0xFE13, 0xFE14, lb::is },
+
+         { 0x17D6, 0x17D6, lb::ns },   { 0x203C, 0x203D, lb::ns },
+         { 0x2047, 0x2049, lb::ns },   { 0x3005, 0x3005, lb::ns },
+         { 0x301C, 0x301C, lb::ns },   { 0x303B, 0x303C, lb::ns },
+         { 0x309B, 0x309E, lb::ns },   { 0x30A0, 0x30A0, lb::ns },
+         { 0x30FB, 0x30FB, lb::ns },   { 0x30FD, 0x30FE, lb::ns },
+         { 0xA015, 0xA015, lb::ns },   { 0xFE54, 0xFE55, lb::ns },
+         { 0xFF1A, 0xFF1B, lb::ns },   { 0xFF65, 0xFF65, lb::ns },
+         { 0xFF9E, 0xFF9F, lb::ns },
+
+         // Small kana (conditional Japanese starters)
+         { 0x3041, 0x3041, lb::cj },   { 0x3043, 0x3043, lb::cj },
+         { 0x3045, 0x3045, lb::cj },   { 0x3047, 0x3047, lb::cj },
+         { 0x3049, 0x3049, lb::cj },   { 0x3063, 0x3063, lb::cj },
+         { 0x3083, 0x3083, lb::cj },   { 0x3085, 0x3085, lb::cj },
+         { 0x3087, 0x3087, lb::cj },   { 0x308E, 0x308E, lb::cj },
+         { 0x3095, 0x3096, lb::cj },   { 0x30A1, 0x30A1, lb::cj },
+         { 0x30A3, 0x30A3, lb::cj },   { 0x30A5, 0x30A5, lb::cj },
+         { 0x30A7, 0x30A7, lb::cj },   { 0x30A9, 0x30A9, lb::cj },
+         { 0x30C3, 0x30C3, lb::cj },   { 0x30E3, 0x30E3, lb::cj },
+         { 0x30E5, 0x30E5, lb::cj },   { 0x30E7, 0x30E7, lb::cj },
+         { 0x30EE, 0x30EE, lb::cj },   { 0x30F5, 0x30F6, lb::cj },
+         { 0x30FC, 0x30FC, lb::cj },   { 0x31F0, 0x31FF, lb::cj },
+
+         // Inseparable, prefix, postfix and symbols
+         { 0x2024, 0x2026, lb::in },   { 0x22EF, 0x22EF, lb::in },
+         { 0xFE19, 0xFE19, lb::in },
+
+         { 0x0024, 0x0024, lb::pr },   { 0x002B, 0x002B, lb::pr },
+         { 0x005C, 0x005C, lb::pr },   { 0x00A3, 0x00A5, lb::pr },
+         { 0x00B1, 0x00B1, lb::pr },   { 0x058F, 0x058F, lb::pr },
+         { 0x20A0, 0x20A6, lb::pr },   { 0x20A8, 0x20B5, lb::pr },
+         { 0x20B7, 0x20CF, lb::pr },   { 0x2116, 0x2116, lb::pr },
+         { 0x2212, 0x2213, lb::pr },   { 0xFE69, 0xFE69, lb::pr },
+         { 0xFF04, 0xFF04, lb::pr },   { 0xFFE1, 0xFFE1, lb::pr },
+         { 0xFFE5, 0xFFE6, lb::pr },
+
+         { 0x0025, 0x0025, lb::po },   { 0x00A2, 0x00A2, lb::po },
+         { 0x00B0, 0x00B0, lb::po },   { 0x0609, 0x060B, lb::po },
+         { 0x066A, 0x066A, lb::po },   { 0x2030, 0x2037, lb::po },
+         { 0x20A7, 0x20A7, lb::po },   { 0x20B6, 0x20B6, lb::po },
+         { 0x2103, 0x2103, lb::po },   { 0x2109, 0x2109, lb::po },
+         { 0xFDFC, 0xFDFC, lb::po },   { 0xFE6A, 0xFE6A, lb::po },
+         { 0xFF05, 0xFF05, lb::po },   { 0xFFE0, 0xFFE0, lb::po },
+
+         { 0x002F, 0x002F, lb::sy },
+
+         // Numbers
+         { 0x0030, 0x0039, lb::nu },   { 0x0660, 0x0669, lb::nu },
+         { 0x066B, 0x066C, lb::nu },   { 0x06F0, 0x06F9, lb::nu },
+         { 0x07C0, 0x07C9, lb::nu },   { 0x0966, 0x096F, lb::nu },
+         { 0x09E6, 0x09EF, lb::nu },   { 0x0A66, 0x0A6F, lb::nu },
+         { 0x0AE6, 0x0AEF, lb::nu },   { 0x0B66, 0x0B6F, lb::nu },
+         { 0x0BE6, 0x0BEF, lb::nu },   { 0x0C66, 0x0C6F, lb::nu },
+         { 0x0CE6, 0x0CEF, lb::nu },   { 0x0D66, 0x0D6F, lb::nu },
+         { 0x0E50, 0x0E59, lb::nu },   { 0x0ED0, 0x0ED9, lb::nu },
+         { 0x0F20, 0x0F29, lb::nu },   { 0x1040, 0x1049, lb::nu },
+         { 0x17E0, 0x17E9, lb::nu },   { 0x1810, 0x1819, lb::nu },
+
+         // Emoji modifiers, regional indicators
+         { 0x1F3FB, 0x1F3FF, lb::em }, { 0x1F1E6, 0x1F1FF, lb::ri },
+      };
+
+      constexpr property_range<wb> word_break_ranges[] =
+      {
+         // Letters
+         { 0x0041, 0x005A, wb::aletter },    { 0x0061, 0x007A, wb::aletter },
+         { 0x00AA, 0x00AA, wb::aletter },    { 0x00B5, 0x00B5, wb::aletter },
+         { 0x00BA, 0x00BA, wb::aletter },    { 0x00C0, 0x00D6, wb::aletter },
+         { 0x00D8, 0x00F6, wb::aletter },    { 0x00F8, 0x02FF, wb::aletter },
+         { 0x0370, 0x0374, wb::aletter },    { 0x0376, 0x037D, wb::aletter },
+         { 0x037F, 0x0386, wb::aletter },    { 0x0388, 0x03FF, wb::aletter },
+         { 0x0400, 0x0482, wb::aletter },    { 0x048A, 0x052F, wb::aletter },
+         { 0x0531, 0x0556, wb::aletter },    { 0x0559, 0x055C, wb::aletter },
+         { 0x0560, 0x0588, wb::aletter },    { 0x0620, 0x064A, wb::aletter },
+         { 0x066E, 0x066F, wb::aletter },    { 0x0671, 0x06D3, wb::aletter },
+         { 0x06D5, 0x06D5, wb::aletter },    { 0x06FA, 0x06FC, wb::aletter },
+         { 0x0904, 0x0939, wb::aletter },    { 0x093D, 0x093D, wb::aletter },
+         { 0x0950, 0x0950, wb::aletter },    { 0x0958, 0x0961, wb::aletter },
+         { 0x0971, 0x0980, wb::aletter },    { 0x10A0, 0x10FF, wb::aletter },
+         { 0x1100, 0x11FF, wb::aletter },    { 0x1E00, 0x1FBC, wb::aletter },
+         { 0x1FC2, 0x1FCC, wb::aletter },    { 0x1FD0, 0x1FDB, wb::aletter },
+         { 0x1FE0, 0x1FEC, wb::aletter },    { 0x1FF2, 0x1FFC, wb::aletter },
+         { 0x2C00, 0x2CE4, wb::aletter },    { 0x2D00, 0x2D6F, wb::aletter },
+         { 0xA640, 0xA66E, wb::aletter },    { 0xA680, 0xA69D, wb::aletter },
+         { 0xA722, 0xA7FF, wb::aletter },    { 0xAC00, 0xD7A3, wb::aletter },
+         { 0xD7B0, 0xD7FB, wb::aletter },    { 0xFB00, 0xFB06, wb::aletter },
+         { 0xFB50, 0xFDFB, wb::aletter },    { 0xFE70, 0xFEFC, wb::aletter },
+         { 0xFF21, 0xFF3A, wb::aletter },    { 0xFF41, 0xFF5A, wb::aletter },
+         { 0xFFA0, 0xFFDC, wb::aletter },
+
+         { 0x05D0, 0x05EA, wb::hebrew_letter },
+         { 0x05EF, 0x05F2, wb::hebrew_letter },
+         { 0xFB1D, 0xFB1D, wb::hebrew_letter },
+         { 0xFB1F, 0xFB28, wb::hebrew_letter },
+         { 0xFB2A, 0xFB4F, wb::hebrew_letter },
+
+         { 0x3031, 0x3035, wb::katakana },   { 0x309B, 0x309C, wb::katakana },
+         { 0x30A0, 0x30FA, wb::katakana },   { 0x30FC, 0x30FF, wb::katakana },
+         { 0x31F0, 0x31FF, wb::katakana },   { 0x32D0, 0x32FE, wb::katakana },
+         { 0x3300, 0x3357, wb::katakana },   { 0xFF66, 0xFF9D, wb::katakana },
+
+         // Marks and format characters
+         { 0x0300, 0x036F, wb::extend },     { 0x0483, 0x0489, wb::extend },
+         { 0x0591, 0x05BD, wb::extend },     { 0x05BF, 0x05BF, wb::extend },
+         { 0x05C1, 0x05C2, wb::extend },     { 0x05C4, 0x05C5, wb::extend },
+         { 0x05C7, 0x05C7, wb::extend },     { 0x0610, 0x061A, wb::extend },
+         { 0x064B, 0x065F, wb::extend },     { 0x0670, 0x0670, wb::extend },
+         { 0x06D6, 0x06DC, wb::extend },     { 0x06DF, 0x06E4, wb::extend },
+         { 0x06E7, 0x06E8, wb::extend },     { 0x06EA, 0x06ED, wb::extend },
+         { 0x0900, 0x0903, wb::extend },     { 0x093A, 0x093C, wb::extend },
+         { 0x093E, 0x094F, wb::extend },     { 0x0951, 0x0957, wb::extend },
+         { 0x0962, 0x0963, wb::extend },     { 0x1AB0, 0x1AFF, wb::extend },
+         { 0x1DC0, 0x1DFF, wb::extend },     { 0x200C, 0x200C, wb::extend },
+         { 0x20D0, 0x20F0, wb::extend },     { 0x302A, 0x302F, wb::extend },
+         { 0x3099, 0x309A, wb::extend },     { 0xFE00, 0xFE0F, wb::extend },
+         { 0xFE20, 0xFE2F, wb::extend },     { 0xFF9E, 0xFF9F, wb::extend },
+         { 0x1F3FB, 0x1F3FF, wb::extend },
+
+         { 0x00AD, 0x00AD, wb::format },     { 0x0600, 0x0605, wb::format },
+         { 0x061C, 0x061C, wb::format },     { 0x06DD, 0x06DD, wb::format },
+         { 0x200E, 0x200F, wb::format },     { 0x202A, 0x202E, wb::format },
+         { 0x2060, 0x2064, wb::format },     { 0x2066, 0x206F, wb::format },
+         { 0xFEFF, 0xFEFF, wb::format },     { 0xFFF9, 0xFFFB, wb::format },
+         { 0x200D, 0x200D, wb::zwj },
+
+         // Numbers and word-internal punctuation
+         { 0x0030, 0x0039, wb::numeric },    { 0x0660, 0x0669, wb::numeric },
+         { 0x066B, 0x066B, wb::numeric },    { 0x06F0, 0x06F9, wb::numeric },
+         { 0x07C0, 0x07C9, wb::numeric },    { 0x0966, 0x096F, wb::numeric },
+         { 0x09E6, 0x09EF, wb::numeric },    { 0x0E50, 0x0E59, wb::numeric },
+         { 0xFF10, 0xFF19, wb::numeric },
+
+         { 0x0027, 0x0027, wb::single_quote },
+         { 0x0022, 0x0022, wb::double_quote },
+
+         { 0x002E, 0x002E, wb::midnumlet },  { 0x2018, 0x2019, wb::midnumlet },
+         { 0x2024, 0x2024, wb::midnumlet },  { 0xFE52, 0xFE52, wb::midnumlet },
+         { 0xFF07, 0xFF07, wb::midnumlet },  { 0xFF0E, 0xFF0E, wb::midnumlet },
+
+         { 0x003A, 0x003A, wb::midletter },  { 0x00B7, 0x00B7, wb::midletter },
+         { 0x0387, 0x0387, wb::midletter },  { 0x05F4, 0x05F4, wb::midletter },
+         { 0x2027, 0x2027, wb::midletter },  { 0xFE13, 0xFE13, wb::midletter },
+         { 0xFE55, 0xFE55, wb::midletter },  { 0xFF1A, 0xFF1A, wb::midletter },
+
+         { 0x002C, 0x002C, wb::midnum },     { 0x003B, 0x003B, wb::midnum },
+         { 0x037E, 0x037E, wb::midnum },     { 0x0589, 0x0589, wb::midnum },
+         { 0x060C, 0x060D, wb::midnum },     { 0x066C, 0x066C, wb::midnum },
+         { 0x07F8, 0x07F8, wb::midnum },     { 0x2044, 0x2044, wb::midnum },
+         { 0xFE10, 0xFE10, wb::midnum },     { 0xFE14, 0xFE14, wb::midnum },
+         { 0xFE50, 0xFE50, wb::midnum },     { 0xFE54, 0xFE54, wb::midnum },
+         { 0xFF0C, 0xFF0C, wb::midnum },     { 0xFF1B, 0xFF1B, wb::midnum },
+
+         { 0x005F, 0x005F, wb::extendnumlet },
+         { 0x202F, 0x202F, wb::extendnumlet },
+         { 0x203F, 0x2040, wb::extendnumlet },
+         { 0x2054, 0x2054, wb::extendnumlet },
+         { 0xFE33, 0xFE34, wb::extendnumlet },
+         { 0xFE4D, 0xFE4F, wb::extendnumlet },
+         { 0xFF3F, 0xFF3F, wb::extendnumlet },
+
+         // Spaces and new lines
+         { 0x0020, 0x0020, wb::wsegspace },  { 0x1680, 0x1680, wb::wsegspace },
+         { 0x2000, 0x2006, wb::wsegspace },  { 0x2008, 0x200A, wb::wsegspace },
+         { 0x205F, 0x205F, wb::wsegspace },  { 0x3000, 0x3000, wb::wsegspace },
+         { 0x000B, 0x000C, wb::newline },    { 0x0085, 0x0085, wb::newline },
+         { 0x2028, 0x2029, wb::newline },    { 0x000A, 0x000A, wb::lf },
+         { 0x000D, 0x000D, wb::cr },
+
+         { 0x1F1E6, 0x1F1FF, wb::regional_indicator },
+      };
+
+      // Punctuation and symbols (general categories P* and S*), as far as
+      // word selection is concerned
+      constexpr codepoint_range punctuation_ranges[] =
+      {
+         { 0x0021, 0x002F }, { 0x003A, 0x0040 }, { 0x005B, 0x0060 },
+         { 0x007B, 0x007E }, { 0x00A1, 0x00A9 }, { 0x00AB, 0x00B1 },
+         { 0x00B4, 0x00B4 }, { 0x00B6, 0x00B8 }, { 0x00BB, 0x00BF },
+         { 0x00D7, 0x00D7 }, { 0x00F7, 0x00F7 }, { 0x037E, 0x037E },
+         { 0x0387, 0x0387 }, { 0x055A, 0x055F }, { 0x0589, 0x058A },
+         { 0x05BE, 0x05BE }, { 0x05C0, 0x05C0 }, { 0x05C3, 0x05C3 },
+         { 0x05C6, 0x05C6 }, { 0x05F3, 0x05F4 }, { 0x0609, 0x060D },
+         { 0x061B, 0x061B }, { 0x061E, 0x061F }, { 0x066A, 0x066D },
+         { 0x06D4, 0x06D4 }, { 0x0964, 0x0965 }, { 0x0970, 0x0970 },
+         { 0x0E4F, 0x0E4F }, { 0x0E5A, 0x0E5B }, { 0x2010, 0x2027 },
+         { 0x2030, 0x205E }, { 0x207A, 0x207E }, { 0x208A, 0x208E },
+         { 0x20A0, 0x20CF }, { 0x2190, 0x2BFF }, { 0x2E00, 0x2E7F },
+         { 0x3001, 0x3004 }, { 0x3008, 0x3020 }, { 0x3030, 0x3030 },
+         { 0x303D, 0x303D }, { 0x30A0, 0x30A0 }, { 0x30FB, 0x30FB },
+         { 0xFD3E, 0xFD3F }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6B },
+         { 0xFF01, 0xFF0F }, { 0xFF1A, 0xFF20 }, { 0xFF3B, 0xFF40 },
+         { 0xFF5B, 0xFF65 }, { 0xFFE0, 0xFFEE },
+      };
+
+      /////////////////////////////////////////////////////////////////////////
+      // Table generation
+      //
+      // The tables cover [0, table_limit) in blocks of 256 codepoints. The
+      // first stage maps a block to its data in the second stage. Blocks
+      // where all codepoints have the same properties share their data.
+      /////////////////////////////////////////////////////////////////////////
+      constexpr uint32_t table_limit = 0x20000;
+      constexpr uint32_t block_size = 256;
+      constexpr uint32_t num_blocks = table_limit / block_size;
+
+      constexpr uint16_t pack(uint32_t cp, lb l, wb w, bool punct)
+      {
+         bool newline = l == lb::bk || l == lb::cr || l == lb::lf || l == lb::nl;
+         bool space = newline || l == lb::sp || w == wb::wsegspace || cp == '\t';
+         unsigned flags =
+              (space ? cp_space : 0)
+            | (newline ? cp_newline : 0)
+            | (punct ? cp_punctuation : 0)
+            ;
+         return uint16_t(unsigned(l) | (unsigned(w) << 6) | (flags << 11));
+      }
+
+      template <typename T, std::size_t N>
+      constexpr void fill(T (&values)[block_size], property_range<T> const (&ranges)[N], uint32_t first)
+      {
+         uint32_t last = first + block_size - 1;
+         for (auto const& r : ranges)
+         {
+            if (r.first > last || r.last < first)
+               continue;
+            uint32_t i = r.first > first ? r.first : first;
+            uint32_t end = r.last < last ? r.last : last;
+            for (; i <= end; ++i)
+               values[i - first] = r.value;
+         }
+      }
+
+      template <std::size_t N>
+      constexpr void fill(bool (&values)[block_size], codepoint_range const (&ranges)[N], uint32_t first)
+      {
+         uint32_t last = first + block_size - 1;
+         for (auto const& r : ranges)
+         {
+            if (r.first > last || r.last < first)
+               continue;
+            uint32_t i = r.first > first ? r.first : first;
+            uint32_t end = r.last < last ? r.last : last;
+            for (; i <= end; ++i)
+               values[i - first] = true;
+         }
+      }
+
+      struct block_data
+      {
+         uint16_t    props[block_size];
+      };
+
+      constexpr block_data compute_block(uint32_t block)
+      {
+         uint32_t first = block * block_size;
+         lb       lbs[block_size] = {};
+         wb       wbs[block_size] = {};
+         bool     punct[block_size] = {};
+
+         fill(lbs, line_break_ranges, first);
+         fill(wbs, word_break_ranges, first);
+         fill(punct, punctuation_ranges, first);
+
+         block_data r = {};
+         for (uint32_t i = 0; i != block_size; ++i)
+            r.props[i] = pack(first + i, lbs[i], wbs[i], punct[i]);
+         return r;
+      }
+
+      // Paint the ranges onto whole blocks. A block is mixed if a range
+      // starts or ends inside it. The values painted on the other blocks
+      // are their uniform values.
+      template <typename T, std::size_t N>
+      constexpr void paint(
+         bool (&mixed)[num_blocks], T (&values)[num_blocks]
+       , property_range<T> const (&ranges)[N]
+      )
+      {
+         for (auto const& r : ranges)
+         {
+            if (r.first >= table_limit)
+               continue;
+            uint32_t last = r.last < table_limit ? r.last : table_limit - 1;
+            if (r.first % block_size != 0)
+               mixed[r.first / block_size] = true;
+            if ((last + 1) % block_size != 0)
+               mixed[last / block_size] = true;
+            for (uint32_t b = r.first / block_size; b <= last / block_size; ++b)
+               values[b] = r.value;
+         }
+      }
+
+      template <std::size_t N>
+      constexpr void paint(
+         bool (&mixed)[num_blocks], bool (&values)[num_blocks]
+       , codepoint_range const (&ranges)[N]
+      )
+      {
+         for (auto const& r : ranges)
+         {
+            if (r.first % block_size != 0)
+               mixed[r.first / block_size] = true;
+            if ((r.last + 1) % block_size != 0)
+               mixed[r.last / block_size] = true;
+            for (uint32_t b = r.first / block_size; b <= r.last / block_size; ++b)
+               values[b] = true;
+         }
+      }
+
+      struct block_kinds
+      {
+         bool        mixed[num_blocks];
+         uint16_t    value[num_blocks];   // if not mixed
+      };
+
+      constexpr block_kinds classify_blocks()
+      {
+         block_kinds kinds = {};
+         lb          lbs[num_blocks] = {};
+         wb          wbs[num_blocks] = {};
+         bool        punct[num_blocks] = {};
+
+         paint(kinds.mixed, lbs, line_break_ranges);
+         paint(kinds.mixed, wbs, word_break_ranges);
+         paint(kinds.mixed, punct, punctuation_ranges);
+
+         for (uint32_t i = 0; i != num_blocks; ++i)
+            kinds.value[i] = pack(i * block_size, lbs[i], wbs[i], punct[i]);
+         return kinds;
+      }
+
+      constexpr block_kinds kinds = classify_blocks();
+
+      // Distinct uniform values. There are only a handful.
+      constexpr std::size_t max_uniform_values = 32;
+
+      struct uniform_values
+      {
+         uint16_t    value[max_uniform_values];
+         std::size_t size;
+      };
+
+      constexpr uniform_values collect_uniform_values()
+      {
+         uniform_values r = {};
+         for (uint32_t i = 0; i != num_blocks; ++i)
+         {
+            if (kinds.mixed[i])
+               continue;
+            std::size_t j = 0;
+            while (j != r.size && r.value[j] != kinds.value[i])
+               ++j;
+            if (j == r.size && r.size != max_uniform_values)
+               r.value[r.size++] = kinds.value[i];
+         }
+         return r;
+      }
+
+      constexpr uniform_values uniform = collect_uniform_values();
+      static_assert(uniform.size < max_uniform_values, "Too many distinct uniform blocks");
+
+      constexpr std::size_t count_mixed()
+      {
+         std::size_t n = 0;
+         for (auto m : kinds.mixed)
+            n += m;
+         return n;
+      }
+
+      // Uniform blocks come first in the second stage, then mixed blocks
+      constexpr std::size_t num_distinct_blocks = uniform.size + count_mixed();
+
+      struct break_table
+      {
+         uint16_t    index[num_blocks];
+         block_data  blocks[num_distinct_blocks];
+      };
+
+      constexpr break_table make_break_table()
+      {
+         break_table t = {};
+         for (std::size_t j = 0; j != uniform.size; ++j)
+         {
+            for (auto& p : t.blocks[j].props)
+               p = uniform.value[j];
+         }
+
+         std::size_t n = uniform.size;
+         for (uint32_t i = 0; i != num_blocks; ++i)
+         {
+            if (kinds.mixed[i])
+            {
+               t.blocks[n] = compute_block(i);
+               t.index[i] = uint16_t(n++);
+            }
+            else
+            {
+               uint16_t j = 0;
+               while (uniform.value[j] != kinds.value[i])
+                  ++j;
+               t.index[i] = j;
+            }
+         }
+         return t;
+      }
+
+      constexpr break_table table = make_break_table();
+
+      // Above the table: CJK ideographs in planes 2 and 3, tags and
+      // variation selectors in plane 14. Everything else takes the defaults.
+      constexpr uint16_t ideograph_props = pack(0x20000, lb::id, wb::other, false);
+      constexpr uint16_t tag_props = pack(0xE0001, lb::cm, wb::extend, false);
+      constexpr uint16_t default_props = pack(0x40000, lb::al, wb::other, false);
+
+      constexpr uint16_t line_break_mask = 0x3F;
+      constexpr uint32_t first_hangul_syllable = 0xAC00;
+      constexpr uint32_t hangul_trailing_consonants = 28;
+
+      inline bool is_korean(lb c)
+      {
+         switch (c)
+         {
+            case lb::jl: case lb::jv: case lb::jt: case lb::h2: case lb::h3:
+               return true;
+            default:
+               return false;
+         }
+      }
+
+      inline bool is_ideographic(lb c)
+      {
+         switch (c)
+         {
+            case lb::id: case lb::cj: case lb::h2: case lb::h3:
+            case lb::eb: case lb::em:
+               return true;
+            default:
+               return false;
+         }
+      }
+   }
+
+   uint16_t break_properties(unsigned codepoint)
+   {
+      if (codepoint < table_limit)
+      {
+         auto props = table.blocks[table.index[codepoint / block_size]].props[codepoint % block_size];
+
+         // An LV syllable: no trailing consonant
+         if ((props & line_break_mask) == uint16_t(lb::h3)
+            && (codepoint - first_hangul_syllable) % hangul_trailing_consonants == 0)
+            props = (props & ~line_break_mask) | uint16_t(lb::h2);
+         return props;
+      }
+      if (codepoint < 0x40000)
+         return ideograph_props;
+      if (codepoint >= 0xE0000 && codepoint <= 0xE0FFF)
+         return tag_props;
+      return default_props;
+   }
+
+   bool is_line_break_opportunity(line_break_class before, line_break_class after)
+   {
+      // Never break before these (LB6, LB7, LB9, LB11, LB12a, LB13, LB16,
+      // LB19, LB21, LB22)
+      switch (after)
+      {
+         case lb::bk: case lb::cr: case lb::lf: case lb::nl:
+         case lb::sp: case lb::zw: case lb::cm: case lb::zwj:
+         case lb::wj: case lb::gl: case lb::cl: case lb::cp:
+         case lb::ex: case lb::is: case lb::sy: case lb::ns:
+         case lb::qu: case lb::ba: case lb::hy: case lb::in:
+            return false;
+         default:
+            break;
+      }
+
+      // Never break after these (LB11, LB12, LB14, LB19, LB21 and LB8a),
+      // always break after these (LB8 and LB21).
+      switch (before)
+      {
+         case lb::op: case lb::qu: case lb::gl: case lb::wj:
+         case lb::bb: case lb::zwj: case lb::sp:
+            return false;
+         case lb::zw: case lb::b2:
+            return true;
+         case lb::ba:
+            return true;
+         case lb::hy:
+            return after != lb::nu;    // LB25: HY x NU
+         default:
+            break;
+      }
+
+      // Korean syllable blocks (LB26, LB27)
+      switch (before)
+      {
+         case lb::jl:
+            if (after == lb::jl || after == lb::jv || after == lb::h2 || after == lb::h3)
+               return false;
+            break;
+         case lb::jv: case lb::h2:
+            if (after == lb::jv || after == lb::jt)
+               return false;
+            break;
+         case lb::jt: case lb::h3:
+            if (after == lb::jt)
+               return false;
+            break;
+         default:
+            break;
+      }
+      if ((is_korean(before) && after == lb::po) || (before == lb::pr && is_korean(after)))
+         return false;
+
+      // Break around ideographs (LB31), but keep everything else together
+      // (LB28 - LB30).
+      return is_ideographic(before) || is_ideographic(after);
+   }
+}}
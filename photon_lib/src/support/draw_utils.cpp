@@ -4,9 +4,57 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <photon/support/draw_utils.hpp>
+#include <photon/support/shadow.hpp>
+#include <photon/support/detail/scratch_context.hpp>
+#include <map>
+#include <tuple>
 
 namespace cycfi { namespace photon
 {
+   namespace
+   {
+      // Fixed shapes are recorded once per size, at the origin, and moved
+      // to where they are drawn. The cache is per thread, like the canvases
+      // using it, and simply starts over when full.
+      using shape_key = std::tuple<int, float, float, float>;
+      constexpr std::size_t shape_cache_size = 256;
+
+      template <typename F>
+      canvas::path const& cached_path(shape_key const& key, F f)
+      {
+         thread_local std::map<shape_key, canvas::path> cache;
+         auto i = cache.find(key);
+         if (i != cache.end())
+            return i->second;
+
+         if (cache.size() >= shape_cache_size)
+            cache.clear();
+
+         thread_local detail::scratch_context scratch;
+         canvas cnv{ *scratch.context() };
+         return cache[key] = cnv.record_path(f);
+      }
+   }
+
+   void add_round_rect(canvas& cnv, rect bounds, float radius)
+   {
+      auto w = bounds.width();
+      auto h = bounds.height();
+      auto const& p = cached_path(shape_key{ 0, w, h, radius },
+         [=](canvas& rec) { rec.round_rect({ 0, 0, w, h }, radius); }
+      );
+      cnv.add_path(p, bounds.top_left());
+   }
+
+   void add_circle(canvas& cnv, circle c)
+   {
+      auto r = c.radius;
+      auto const& p = cached_path(shape_key{ 1, r, r, r },
+         [=](canvas& rec) { rec.circle({ 0, 0, r }); }
+      );
+      cnv.add_path(p, c.center());
+   }
+
    void draw_box_vgradient(canvas& cnv, rect bounds, float corner_radius)
    {
       auto gradient = canvas::linear_gradient{
@@ -19,7 +67,7 @@ namespace cycfi { namespace photon
       cnv.fill_style(gradient);
 
       cnv.begin_path();
-      cnv.round_rect(bounds, corner_radius);
+      add_round_rect(cnv, bounds, corner_radius);
       cnv.fill();
 
       cnv.begin_path();
@@ -34,48 +82,21 @@ namespace cycfi { namespace photon
    {
       // Panel fill
       cnv.begin_path();
-      cnv.round_rect(bounds, corner_radius);
+      add_round_rect(cnv, bounds, corner_radius);
       cnv.fill_style(c);
       cnv.fill();
 
-      // Simulated blurred shadow. cairo does not have blur yet :-(
+      // Drop shadow, outside the panel only
       {
          auto save = cnv.new_state();
 
          cnv.begin_path();
          cnv.rect(bounds.inset(-100, -100));
-         cnv.round_rect(bounds.inset(0.5, 0.5), corner_radius);
+         add_round_rect(cnv, bounds.inset(0.5, 0.5), corner_radius);
          cnv.fill_rule(canvas::fill_odd_even);
          cnv.clip();
 
-         rect shr = bounds;
-         shr.left -= 2;
-         shr.top -= 2;
-         shr.right += 6;
-         shr.bottom += 6;
-
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius*2);
-         cnv.fill_style(rgba(0, 0, 0, 20));
-         cnv.fill();
-
-         shr.left += 1;
-         shr.top += 1;
-         shr.right -= 2;
-         shr.bottom -= 2;
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius*1.5);
-         cnv.fill_style(rgba(0, 0, 0, 30));
-         cnv.fill();
-
-         shr.left += 1;
-         shr.top += 1;
-         shr.right -= 2;
-         shr.bottom -= 2;
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius);
-         cnv.fill_style(rgba(0, 0, 0, 40));
-         cnv.fill();
+         draw_shadow(cnv, bounds.move(1, 2), corner_radius, 6, rgba(0, 0, 0, 96));
       }
    }
 
@@ -91,15 +112,15 @@ namespace cycfi { namespace photon
       cnv.fill_style(gradient);
 
       cnv.begin_path();
-      cnv.round_rect(bounds.inset(1, 1), corner_radius-1);
+      add_round_rect(cnv, bounds.inset(1, 1), corner_radius-1);
       cnv.fill_style(c);
       cnv.fill();
-      cnv.round_rect(bounds.inset(1, 1), corner_radius-1);
+      add_round_rect(cnv, bounds.inset(1, 1), corner_radius-1);
       cnv.fill_style(gradient);
       cnv.fill();
 
       cnv.begin_path();
-      cnv.round_rect(bounds.inset(0.5, 0.5), corner_radius-0.5);
+      add_round_rect(cnv, bounds.inset(0.5, 0.5), corner_radius-0.5);
       cnv.stroke_style(rgba(0, 0, 0, 48));
       cnv.stroke();
    }
@@ -123,7 +144,7 @@ namespace cycfi { namespace photon
 
          cnv.fill_style(gradient);
          cnv.begin_path();
-         cnv.circle(cp.inset(inset));
+         add_circle(cnv, cp.inset(inset));
          cnv.fill();
       }
 
@@ -140,14 +161,14 @@ namespace cycfi { namespace photon
 
          cnv.fill_style(gradient);
          cnv.begin_path();
-         cnv.circle(cp.inset(inset));
+         add_circle(cnv, cp.inset(inset));
          cnv.fill();
       }
 
       // Draw the outline
       {
          cnv.stroke_style(colors::black.opacity(0.1));
-         cnv.circle(cp.inset(inset));
+         add_circle(cnv, cp.inset(inset));
          cnv.line_width(radius/30);
          cnv.stroke();
       }
@@ -155,8 +176,8 @@ namespace cycfi { namespace photon
       // Draw knob rim
       {
          cnv.begin_path();
-         cnv.circle(cp);
-         cnv.circle(cp.inset(inset));
+         add_circle(cnv, cp);
+         add_circle(cnv, cp.inset(inset));
          cnv.fill_rule(canvas::fill_odd_even);
          cnv.clip();
 
@@ -181,7 +202,7 @@ namespace cycfi { namespace photon
    {
       cnv.fill_style(c);
       cnv.begin_path();
-      cnv.round_rect(bounds, bounds.height()/12);
+      add_round_rect(cnv, bounds, bounds.height()/12);
       cnv.fill();
    }
 
@@ -194,7 +215,7 @@ namespace cycfi { namespace photon
       {
          cnv.fill_style(c);
          cnv.begin_path();
-         cnv.circle(cp);
+         add_circle(cnv, cp);
          cnv.fill();
       }
 
@@ -211,7 +232,7 @@ namespace cycfi { namespace photon
 
          cnv.fill_style(gradient);
          cnv.begin_path();
-         cnv.circle(cp);
+         add_circle(cnv, cp);
          cnv.fill();
       }
 
@@ -219,7 +240,7 @@ namespace cycfi { namespace photon
       {
          cnv.fill_style(ic);
          cnv.begin_path();
-         cnv.circle(cp.inset(cp.radius * 0.55));
+         add_circle(cnv, cp.inset(cp.radius * 0.55));
          cnv.fill();
       }
 
@@ -237,12 +258,12 @@ namespace cycfi { namespace photon
 
          circle cpf = cp;
          cnv.begin_path();
-         cnv.circle(cpf);
+         add_circle(cnv, cpf);
          cpf.radius *= 0.9;
-         cnv.circle(cpf);
+         add_circle(cnv, cpf);
          cnv.clip();
 
-         cnv.circle(cp);
+         add_circle(cnv, cp);
          cnv.fill();
       }
    }
@@ -261,16 +282,16 @@ namespace cycfi { namespace photon
          bounds = bounds.inset(0, -r);
 
       cnv.begin_path();
-      cnv.round_rect(bounds, r);
+      add_round_rect(cnv, bounds, r);
       cnv.clip();
 
       cnv.fill_style(colors::black);
-      cnv.round_rect(bounds, r);
+      add_round_rect(cnv, bounds, r);
       cnv.fill();
 
       auto lwidth = r/4;
       cnv.stroke_style(colors::white.opacity(0.3));
-      cnv.round_rect(bounds.move(-lwidth, -lwidth), r*0.6);
+      add_round_rect(cnv, bounds.move(-lwidth, -lwidth), r*0.6);
       cnv.line_width(lwidth*1.5);
       cnv.stroke();
    }
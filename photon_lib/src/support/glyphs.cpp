@@ -5,10 +5,183 @@
 =============================================================================*/
 #include <photon/support/glyphs.hpp>
 #include <photon/support/detail/scratch_context.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
 
 namespace cycfi { namespace photon
 {
-   static detail::scratch_context scratch_context_;
+   namespace detail
+   {
+      // The glyphs of the ASCII characters 0x01 to 0x7F of a scaled font
+      struct ascii_glyphs
+      {
+         uint32_t          index[128];
+         float             advance[128];
+         float             pitch;         // Advance of all printable ASCII
+                                          // if they are the same, else 0
+         float             max_advance;   // Widest printable ASCII
+      };
+   }
+
+   namespace
+   {
+      // Each thread shapes text through its own scratch context. Cairo
+      // contexts may not be shared across threads, but scaled fonts may.
+      detail::scratch_context& scratch_context()
+      {
+         thread_local detail::scratch_context scratch_context_;
+         return scratch_context_;
+      }
+
+      ////////////////////////////////////////////////////////////////////////
+      // font_cache: The scaled fonts shared by all master_glyphs, keyed by
+      // face, size, style and display scale. Lookups are thread-safe.
+      ////////////////////////////////////////////////////////////////////////
+      class font_cache
+      {
+      public:
+
+         using scaled_font = cairo_scaled_font_t;
+
+         ~font_cache()
+         {
+            for (auto& p : _fonts)
+               cairo_scaled_font_destroy(p.second);
+            for (auto& p : _ascii)
+               cairo_scaled_font_destroy(p.first);
+         }
+
+         // Returns a new reference to the scaled font
+         scaled_font* get(char const* face, float size, int style, float scale)
+         {
+            key_type key{ face, size, style, scale };
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               auto i = _fonts.find(key);
+               if (i != _fonts.end())
+                  return cairo_scaled_font_reference(i->second);
+            }
+
+            // Resolve the font outside the lock. If another thread got here
+            // first, keep the font it made.
+            auto cr = scratch_context().context();
+            canvas cnv{ *cr };
+            cnv.font(face, size, style);
+            cairo_scale(cr, scale, scale);
+            auto font = cairo_scaled_font_reference(cairo_get_scaled_font(cr));
+            cairo_identity_matrix(cr);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto r = _fonts.emplace(key, font);
+            if (!r.second)
+               cairo_scaled_font_destroy(font);
+            return cairo_scaled_font_reference(r.first->second);
+         }
+
+         // Returns a new reference to font, made for another display scale.
+         // Cairo keeps its own cache of these.
+         static scaled_font* rescale(scaled_font* font, float scale)
+         {
+            cairo_matrix_t font_matrix, ctm;
+            cairo_scaled_font_get_font_matrix(font, &font_matrix);
+            cairo_matrix_init_scale(&ctm, scale, scale);
+            auto options = cairo_font_options_create();
+            cairo_scaled_font_get_font_options(font, options);
+            auto r = cairo_scaled_font_create(
+               cairo_scaled_font_get_font_face(font), &font_matrix, &ctm, options);
+            cairo_font_options_destroy(options);
+            return r;
+         }
+
+         // The ASCII glyphs of font, or null if some ASCII character does
+         // not map to exactly one glyph.
+         detail::ascii_glyphs const* ascii(scaled_font* font)
+         {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               auto i = _ascii.find(font);
+               if (i != _ascii.end())
+                  return i->second.get();
+            }
+
+            auto info = make_ascii(font);
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto r = _ascii.emplace(font, std::move(info));
+            if (r.second)
+               cairo_scaled_font_reference(font);
+            return r.first->second.get();
+         }
+
+      private:
+
+         using key_type = std::tuple<std::string, float, int, float>;
+         using ascii_ptr = std::unique_ptr<detail::ascii_glyphs>;
+
+         static ascii_ptr make_ascii(scaled_font* font)
+         {
+            auto info = ascii_ptr{ new detail::ascii_glyphs{} };
+            bool fixed = true;
+            for (int c = 1; c != 128; ++c)
+            {
+               char                    str[] = { char(c) };
+               cairo_glyph_t*          glyphs_ = nullptr;
+               int                     glyph_count = 0;
+               cairo_text_cluster_t*   clusters_ = nullptr;
+               int                     cluster_count = 0;
+               cairo_text_cluster_flags_t flags;
+
+               auto stat = cairo_scaled_font_text_to_glyphs(
+                  font, 0, 0, str, 1,
+                  &glyphs_, &glyph_count, &clusters_, &cluster_count, &flags);
+
+               bool ok = (stat == CAIRO_STATUS_SUCCESS) && glyph_count == 1;
+               if (ok)
+               {
+                  cairo_text_extents_t extents;
+                  cairo_scaled_font_glyph_extents(font, glyphs_, 1, &extents);
+                  info->index[c] = uint32_t(glyphs_[0].index);
+                  info->advance[c] = float(extents.x_advance);
+               }
+
+               if (glyphs_)
+                  cairo_glyph_free(glyphs_);
+               if (clusters_)
+                  cairo_text_cluster_free(clusters_);
+               if (!ok)
+                  return nullptr;
+
+               if (c >= ' ' && c != 0x7F)
+               {
+                  auto advance_ = info->advance[c];
+                  if (std::abs(advance_ - info->advance[int(' ')]) > 1.0f / 64)
+                     fixed = false;
+                  info->max_advance = std::max(info->max_advance, advance_);
+               }
+            }
+            info->pitch = fixed ? info->advance[int(' ')] : 0;
+            return info;
+         }
+
+         std::mutex                          _mutex;
+         std::map<key_type, scaled_font*>    _fonts;
+         std::map<scaled_font*, ascii_ptr>   _ascii;
+      };
+
+      font_cache fonts_;
+
+      // A view that is not on a display yet may have no scale (0). Fonts
+      // made with it would be singular.
+      float valid_scale(float scale)
+      {
+         return scale > 0 ? scale : 1;
+      }
+   }
 
    glyphs::glyphs(char const* first, char const* last)
     : _first(first)
@@ -24,6 +197,7 @@ namespace cycfi { namespace photon
     , int cluster_start, int cluster_end
     , master_glyphs const& master
     , bool strip_leading_spaces
+    , float pitch
    )
     : _first(first)
     , _last(last)
@@ -33,6 +207,7 @@ namespace cycfi { namespace photon
     , _clusters(master._clusters + cluster_start)
     , _cluster_count(cluster_end - cluster_start)
     , _clusterflags(master._clusterflags)
+    , _pitch(pitch)
    {
       CYCFI_ASSERT(_first, "Precondition failure: _first must not be null");
       CYCFI_ASSERT(_last, "Precondition failure: _last must not be null");
@@ -49,20 +224,24 @@ namespace cycfi { namespace photon
 
       auto  strip_leading = [this](auto f)
       {
-         int      glyph_index = 0;
-         unsigned codepoint;
-         unsigned state = 0;
+         int                  glyph_index = 0;
+         char const*          first = _first;
+         char const*          i = _first;
+         decoded_codepoint    cps[16];
 
-         cairo_text_cluster_t* cluster = _clusters;
-         for (auto i = _first; i != _last; ++i)
+         auto cluster = _clusters;
+         while (i != _last)
          {
-            if (!decode_utf8(state, codepoint, uint8_t(*i)))
+            auto n = decode_utf8(i, _last, cps, 16);
+            auto j = std::find_if_not(cps, cps + n, f);
+            for (auto k = cps; k != j; ++k)
+               glyph_index += (cluster++)->num_glyphs;
+            if (j != cps + n)
             {
-               if (!f(codepoint))
-                  break;
-               glyph_index += cluster->num_glyphs;
-               ++cluster;
+               first = j->pos;
+               break;
             }
+            first = i;
          }
 
          auto   clusters_skipped = int(cluster - _clusters);
@@ -71,12 +250,12 @@ namespace cycfi { namespace photon
          _glyphs += glyph_index;
          _cluster_count -= clusters_skipped;
          _clusters = cluster;
-         _first += clusters_skipped;
+         _first = first;
       };
 
       if (strip_leading_spaces)
-         strip_leading([](auto cp){ return !is_newline(cp) && is_space(cp); });
-      strip_leading([](auto cp){ return is_newline(cp); });
+         strip_leading([](auto const& cp){ return (cp.flags & (cp_space | cp_newline)) == cp_space; });
+      strip_leading([](auto const& cp){ return (cp.flags & cp_newline) != 0; });
    }
 
    void glyphs::draw(point pos, canvas& canvas_)
@@ -89,17 +268,34 @@ namespace cycfi { namespace photon
       CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
       CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
 
+      // Make the cairo glyphs and clusters for this row only. The buffers
+      // are kept around for the next row.
+      thread_local std::vector<cairo_glyph_t> glyphs_;
+      thread_local std::vector<cairo_text_cluster_t> clusters_;
+
+      glyphs_.resize(_glyph_count);
+      double x = 0;
+      for (int i = 0; i != _glyph_count; ++i)
+      {
+         glyphs_[i] = { _glyphs[i].index, x, 0 };
+         x += _glyphs[i].advance;
+      }
+
+      clusters_.resize(_cluster_count);
+      for (int i = 0; i != _cluster_count; ++i)
+         clusters_[i] = { _clusters[i].num_bytes, _clusters[i].num_glyphs };
+
       auto cr = &canvas_.cairo_context();
       auto state = canvas_.new_state();
 
       cairo_set_scaled_font(cr, _scaled_font);
-      cairo_translate(cr, pos.x - _glyphs->x, pos.y - _glyphs->y);
+      cairo_translate(cr, pos.x, pos.y);
       canvas_.apply_fill_style();
 
       cairo_show_text_glyphs(
          cr, _first, int(_last - _first),
-         _glyphs, _glyph_count,
-         _clusters, _cluster_count, _clusterflags
+         glyphs_.data(), _glyph_count,
+         clusters_.data(), _cluster_count, _clusterflags
       );
    }
 
@@ -112,14 +308,71 @@ namespace cycfi { namespace photon
       CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
       CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
 
-      if (_glyph_count)
+      if (_pitch > 0)
+         return _cluster_count * _pitch;
+
+      float r = 0;
+      for (int i = 0; i != _glyph_count; ++i)
+         r += _glyphs[i].advance;
+      return r;
+   }
+
+   glyphs::glyph_span glyphs::glyph_at(float x) const
+   {
+      glyph_span r{ nullptr, 0, 0 };
+      if (_first == _last || x < 0)
+         return r;
+
+      // On a grid, the glyph is simply the column at x
+      if (_pitch > 0)
+      {
+         auto col = int(x / _pitch);
+         if (col < _cluster_count)
+            r = { _first + col, col * _pitch, (col + 1) * _pitch };
+         return r;
+      }
+
+      for_each(
+         [x, &r](char const* utf8, float left, float right)
+         {
+            if (x >= left && x < right)
+            {
+               r = { utf8, left, right };
+               return false;
+            }
+            return true;
+         }
+      );
+      return r;
+   }
+
+   glyphs::glyph_span glyphs::glyph_of(char const* s) const
+   {
+      glyph_span r{ nullptr, 0, 0 };
+      if (_first == _last)
+         return r;
+
+      // On a grid, each glyph is one byte
+      if (_pitch > 0)
       {
-         cairo_text_extents_t extents;
-         auto glyph = _glyphs + _glyph_count -1;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-         return (glyph->x + extents.x_advance) - _glyphs->x;
+         auto col = int(std::max<std::ptrdiff_t>(s - _first, 0));
+         if (col < _cluster_count)
+            r = { _first + col, col * _pitch, (col + 1) * _pitch };
+         return r;
       }
-      return 0;
+
+      for_each(
+         [s, &r](char const* utf8, float left, float right)
+         {
+            if (utf8 >= s)
+            {
+               r = { utf8, left, right };
+               return false;
+            }
+            return true;
+         }
+      );
+      return r;
    }
 
    glyphs::font_metrics glyphs::metrics() const
@@ -138,89 +391,235 @@ namespace cycfi { namespace photon
    master_glyphs::master_glyphs(
        char const* first, char const* last
      , char const* face, float size, int style
+     , float scale
    )
     : glyphs(first, last)
+    , _monospace(style & canvas::monospace)
+    , _scale(valid_scale(scale))
+   {
+      _scaled_font = fonts_.get(face, size, style, _scale);
+      init_grid();
+      build();
+   }
+
+   void master_glyphs::init_grid()
+   {
+      // Lay out ASCII on a grid if the font is fixed pitch or if we are
+      // asked to. ASCII is then not shaped at all.
+      _ascii = nullptr;
+      _grid = 0;
+      if (auto ascii = fonts_.ascii(_scaled_font))
+      {
+         _grid = _monospace ? ascii->max_advance : ascii->pitch;
+         if (_grid > 0)
+            _ascii = ascii;
+      }
+   }
+
+   void master_glyphs::scale(float scale_)
    {
-      canvas cnv{ *scratch_context_.context() };
-      cnv.font(face, size, style);
-      auto cr = scratch_context_.context();
-      _scaled_font = cairo_scaled_font_reference(cairo_get_scaled_font(cr));
+      scale_ = valid_scale(scale_);
+      if (scale_ == _scale || !_scaled_font)
+         return;
+
+      auto font = font_cache::rescale(_scaled_font, scale_);
+      cairo_scaled_font_destroy(_scaled_font);
+      _scaled_font = font;
+      _scale = scale_;
+      init_grid();
       build();
    }
 
    master_glyphs::master_glyphs(char const* first, char const* last, master_glyphs const& source)
     : glyphs(first, last)
    {
-      canvas cnv{ *scratch_context_.context() };
       _scaled_font = cairo_scaled_font_reference(source._scaled_font);
+      _ascii = source._ascii;
+      _grid = source._grid;
+      _monospace = source._monospace;
+      _scale = source._scale;
       build();
    }
 
+   master_glyphs::master_glyphs(
+      char const* first, char const* last
+    , std::vector<master_glyphs const*> const& parts
+   )
+    : glyphs(first, last)
+   {
+      CYCFI_ASSERT(!parts.empty(), "Precondition failure: parts must not be empty");
+
+      _scaled_font = cairo_scaled_font_reference(parts.front()->_scaled_font);
+      _ascii = parts.front()->_ascii;
+      _grid = parts.front()->_grid;
+      _monospace = parts.front()->_monospace;
+      _scale = parts.front()->_scale;
+
+      std::size_t num_glyphs = 0;
+      std::size_t num_clusters = 0;
+      for (auto part : parts)
+      {
+         num_glyphs += part->_glyph_store.size();
+         num_clusters += part->_cluster_store.size();
+      }
+
+      // Glyph positions are relative, so the parts simply follow each other
+      _glyph_store.reserve(num_glyphs);
+      _cluster_store.reserve(num_clusters);
+      for (auto part : parts)
+      {
+         if (part->_glyph_store.empty())
+            continue;
+         _clusterflags = part->_clusterflags;
+         _glyph_store.insert(
+            _glyph_store.end(), part->_glyph_store.begin(), part->_glyph_store.end());
+         _cluster_store.insert(
+            _cluster_store.end(), part->_cluster_store.begin(), part->_cluster_store.end());
+      }
+      update();
+   }
+
    master_glyphs::master_glyphs(master_glyphs&& rhs)
     : glyphs(rhs._first, rhs._last)
+    , _ascii(rhs._ascii)
+    , _grid(rhs._grid)
+    , _monospace(rhs._monospace)
+    , _scale(rhs._scale)
+    , _glyph_store(std::move(rhs._glyph_store))
+    , _cluster_store(std::move(rhs._cluster_store))
    {
       _scaled_font = rhs._scaled_font;
-      _glyphs = rhs._glyphs;
-      _glyph_count = rhs._glyph_count;
-      _clusters = rhs._clusters;
-      _cluster_count = rhs._cluster_count;
       _clusterflags = rhs._clusterflags;
+      update();
 
-      rhs._glyphs = nullptr;
-      rhs._clusters = nullptr;
       rhs._scaled_font = nullptr;
+      rhs.update();
    }
 
    master_glyphs& master_glyphs::operator=(master_glyphs&& rhs)
    {
       if (&rhs != this)
       {
+         if (_scaled_font)
+            cairo_scaled_font_destroy(_scaled_font);
+
          _first = rhs._first;
          _last = rhs._last;
          _scaled_font = rhs._scaled_font;
-         _glyphs = rhs._glyphs;
-         _glyph_count = rhs._glyph_count;
-         _clusters = rhs._clusters;
-         _cluster_count = rhs._cluster_count;
          _clusterflags = rhs._clusterflags;
+         _ascii = rhs._ascii;
+         _grid = rhs._grid;
+         _monospace = rhs._monospace;
+         _scale = rhs._scale;
+         _glyph_store = std::move(rhs._glyph_store);
+         _cluster_store = std::move(rhs._cluster_store);
+         update();
 
-         rhs._glyphs = nullptr;
-         rhs._clusters = nullptr;
          rhs._scaled_font = nullptr;
+         rhs._glyph_store.clear();
+         rhs._cluster_store.clear();
+         rhs.update();
       }
       return *this;
    }
 
    master_glyphs::~master_glyphs()
    {
-      if (_glyphs)
-         cairo_glyph_free(_glyphs);
-      if (_clusters)
-         cairo_text_cluster_free(_clusters);
       if (_scaled_font)
          cairo_scaled_font_destroy(_scaled_font);
-
-      _glyphs = nullptr;
-      _clusters = nullptr;
       _scaled_font = nullptr;
    }
 
    void master_glyphs::text(char const* first, char const* last)
    {
-      if (_glyphs)
+      _first = first;
+      _last = last;
+      build();
+   }
+
+   void master_glyphs::adopt_rows(
+      master_glyphs const& part
+    , std::vector<glyphs>& rows
+    , part_offset& offset
+   ) const
+   {
+      for (auto& row : rows)
+      {
+         auto size = row._last - row._first;
+         row._first = _first + offset.text + (row._first - part._first);
+         row._last = row._first + size;
+         row._scaled_font = _scaled_font;
+         row._glyphs = _glyphs + offset.glyph + (row._glyphs - part._glyphs);
+         row._clusters = _clusters + offset.cluster + (row._clusters - part._clusters);
+      }
+      offset.text += part._last - part._first;
+      offset.glyph += part._glyph_count;
+      offset.cluster += part._cluster_count;
+   }
+
+   void master_glyphs::rebind(char const* first, char const* last)
+   {
+      CYCFI_ASSERT((last - first) == (_last - _first),
+         "Precondition failure: [first, last) must be a copy of the text");
+      _first = first;
+      _last = last;
+   }
+
+   void master_glyphs::replace(
+      char const* first, char const* last
+    , std::size_t pos, std::size_t n
+    , master_glyphs const& ins
+   )
+   {
+      // Find the clusters (and glyphs) starting at pos and at pos + n
+      int         start_cluster = -1;
+      int         start_glyph = 0;
+      int         end_cluster = -1;
+      int         end_glyph = 0;
+      std::size_t byte_index = 0;
+      int         glyph_index = 0;
+      for (int i = 0; i <= _cluster_count && byte_index <= pos + n; ++i)
       {
-         cairo_glyph_free(_glyphs);
-         _glyphs = nullptr;
+         if (byte_index == pos)
+         {
+            start_cluster = i;
+            start_glyph = glyph_index;
+         }
+         if (byte_index == pos + n)
+         {
+            end_cluster = i;
+            end_glyph = glyph_index;
+            break;
+         }
+         if (i != _cluster_count)
+         {
+            byte_index += _clusters[i].num_bytes;
+            glyph_index += _clusters[i].num_glyphs;
+         }
       }
-      if (_clusters)
+
+      // Shape it all if pos or pos + n is inside a cluster
+      if (start_cluster < 0 || end_cluster < 0 || ins._scaled_font != _scaled_font)
       {
-         cairo_text_cluster_free(_clusters);
-         _clusters = nullptr;
+         text(first, last);
+         return;
       }
 
+      _glyph_store.erase(
+         _glyph_store.begin() + start_glyph, _glyph_store.begin() + end_glyph);
+      _glyph_store.insert(
+         _glyph_store.begin() + start_glyph
+       , ins._glyph_store.begin(), ins._glyph_store.end());
+
+      _cluster_store.erase(
+         _cluster_store.begin() + start_cluster, _cluster_store.begin() + end_cluster);
+      _cluster_store.insert(
+         _cluster_store.begin() + start_cluster
+       , ins._cluster_store.begin(), ins._cluster_store.end());
+
       _first = first;
       _last = last;
-      build();
+      update();
    }
 
    void master_glyphs::break_lines(float width, std::vector<glyphs>& lines)
@@ -241,7 +640,16 @@ namespace cycfi { namespace photon
       int         start_cluster_index = 0;
       int         space_glyph_index = 0;
       int         space_cluster_index = 0;
-      float       start_x = _glyphs->x;
+      float       x = 0;         // Where the current glyph is in the row
+      float       space_x = 0;   // Where the marked glyph is in the row
+
+      // Count the glyphs off the grid, if any. A row with none is measured
+      // and hit tested with plain arithmetic.
+      int         off_grid = 0;
+      int         start_off_grid = 0;
+      int         space_off_grid = 0;
+
+      auto pitch = [&](int off_grid_) { return off_grid_ == start_off_grid ? _grid : 0; };
 
       auto add_line = [&]()
       {
@@ -251,47 +659,79 @@ namespace cycfi { namespace photon
           , start_cluster_index, space_cluster_index
           , *this
           , lines.size() > 0 // skip leading spaces if this is not the first line
+          , pitch(space_off_grid)
          };
          lines.push_back(std::move(glyph_));
          first = space_pos;
          start_glyph_index = space_glyph_index;
          start_cluster_index = space_cluster_index;
-         start_x = _glyphs[space_glyph_index].x;
+         start_off_grid = space_off_grid;
+         x -= space_x;
+         space_x = 0;
       };
 
-      int      glyph_index = 0;
-      unsigned codepoint;
-      unsigned state = 0;
+      auto mark = [&](decoded_codepoint const* cp, int glyph_index, cluster const* cluster)
+      {
+         space_glyph_index = glyph_index;
+         space_cluster_index = int(cluster - _clusters);
+         space_pos = cp->pos;
+         space_x = x;
+         space_off_grid = off_grid;
+      };
 
-      cairo_text_cluster_t* cluster = _clusters;
-      for (auto i = _first; i != _last; ++i)
+      auto on_grid = [&](cluster const* cluster, int glyph_index)
       {
-         if (!decode_utf8(state, codepoint, uint8_t(*i)))
+         return _grid > 0 && cluster->num_bytes == 1 && cluster->num_glyphs == 1
+            && _glyphs[glyph_index].advance == _grid;
+      };
+
+      int                  glyph_index = 0;
+      char const*          i = _first;
+      decoded_codepoint    cps[64];
+      auto                 prev_class = line_break_class::bk;
+
+      auto cluster = _clusters;
+      while (i != _last)
+      {
+         auto n = decode_utf8(i, _last, cps, 64);
+         for (auto cp = cps; cp != cps + n; ++cp)
          {
-            cairo_glyph_t*  glyph = _glyphs + glyph_index;
+            // Mark break opportunities other than spaces (e.g. after
+            // hyphens and between ideographs) right before this glyph.
+            if (glyph_index != start_glyph_index
+               && is_line_break_opportunity(prev_class, cp->line_break))
+               mark(cp, glyph_index, cluster);
+            prev_class = cp->line_break;
 
             // Check if we exceeded the line width:
-            cairo_text_extents_t extents;
-            cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-            if (((glyph->x + extents.x_advance) - start_x) > width)
+            auto advance_ = advance(*cluster, glyph_index);
+            if ((x + advance_) > width)
             {
-               // Add the line if we did (exceed the line width)
-               add_line();
+               // If there is no break opportunity in the line so far (a word
+               // longer than the line), break right before this glyph.
+               if (space_glyph_index == start_glyph_index && glyph_index != start_glyph_index)
+                  mark(cp, glyph_index, cluster);
+
+               // Add the line if we did (exceed the line width). A glyph
+               // wider than the line is left alone on its own line.
+               if (space_glyph_index != start_glyph_index)
+                  add_line();
             }
 
             // Did we have a space?
-            else if (is_space(codepoint))
+            if (cp->flags & cp_space)
             {
                // Mark the spaces for later
-               space_glyph_index = glyph_index;
-               space_cluster_index = int(cluster - _clusters);
-               space_pos = i;
+               mark(cp, glyph_index, cluster);
 
                // If we got an explicit new line, add the line right away.
-               if ((space_glyph_index != start_glyph_index) && is_newline(codepoint))
+               if ((space_glyph_index != start_glyph_index) && (cp->flags & cp_newline))
                   add_line();
             }
 
+            if (!on_grid(cluster, glyph_index))
+               ++off_grid;
+            x += advance_;
             glyph_index += cluster->num_glyphs;
             ++cluster;
          }
@@ -303,6 +743,7 @@ namespace cycfi { namespace photon
        , start_cluster_index, _cluster_count
        , *this
        , lines.size() > 1 // skip leading spaces if this is not the first line
+       , pitch(off_grid)
       };
 
       lines.push_back(std::move(glyph_));
@@ -310,20 +751,128 @@ namespace cycfi { namespace photon
 
    void master_glyphs::build()
    {
-      // reurn early if there's nothing to build
-      if (_first == _last)
-         return;
+      _glyph_store.clear();
+      _cluster_store.clear();
+
+      // Expect about one glyph and one cluster per codepoint
+      auto num_codepoints = std::count_if(_first, _last,
+         [](char c) { return (uint8_t(c) & 0xC0) != 0x80; });
+      _glyph_store.reserve(num_codepoints);
+      _cluster_store.reserve(num_codepoints);
+
+      // Shape a paragraph (or a run of them) at a time. Cairo hands out
+      // full size glyph and cluster arrays. For big texts, we do not want
+      // all of them alive at once. Nothing is shaped across a newline.
+      constexpr std::size_t chunk_size = 64 * 1024;
+      auto first = _first;
+      while (first != _last)
+      {
+         auto last = _last;
+         if (std::size_t(last - first) > chunk_size)
+         {
+            auto nl = static_cast<char const*>(
+               std::memchr(first + chunk_size, '\n', (last - first) - chunk_size));
+            if (nl)
+               last = nl + 1;
+         }
+         if (_ascii)
+         {
+            // Shape only what is not ASCII
+            auto is_ascii = [](char c) { return static_cast<unsigned char>(c) - 1u < 0x7Fu; };
+            while (first != last)
+            {
+               auto ascii_last = std::find_if_not(first, last, is_ascii);
+               shape_ascii(first, ascii_last);
+               first = std::find_if(ascii_last, last, is_ascii);
+               if (ascii_last != first)
+                  shape(ascii_last, first);
+            }
+         }
+         else
+         {
+            shape(first, last);
+         }
+         first = last;
+      }
+
+      update();
+   }
+
+   void master_glyphs::shape_ascii(char const* first, char const* last)
+   {
+      // One glyph per character, each one column wide
+      for (auto i = first; i != last; ++i)
+      {
+         _glyph_store.push_back({ _ascii->index[int(*i)], _grid });
+         _cluster_store.push_back({ 1, 1 });
+      }
+   }
+
+   void master_glyphs::shape(char const* first, char const* last)
+   {
+      cairo_glyph_t*          glyphs_ = nullptr;
+      int                     glyph_count = 0;
+      cairo_text_cluster_t*   clusters_ = nullptr;
+      int                     cluster_count = 0;
 
       auto stat = cairo_scaled_font_text_to_glyphs(
-         _scaled_font, 0, 0, _first, int(_last - _first),
-         &_glyphs, &_glyph_count, &_clusters, &_cluster_count,
+         _scaled_font, 0, 0, first, int(last - first),
+         &glyphs_, &glyph_count, &clusters_, &cluster_count,
          &_clusterflags);
 
-      if (stat != CAIRO_STATUS_SUCCESS)
+      auto fits = [](int n) { return n >= 0 && n <= 0xFF; };
+      bool ok = (stat == CAIRO_STATUS_SUCCESS);
+      for (int i = 0; ok && i != cluster_count; ++i)
+         ok = fits(clusters_[i].num_bytes) && fits(clusters_[i].num_glyphs);
+
+      if (ok)
       {
-         _glyphs = nullptr;
-         _clusters = nullptr;
+         // Keep only the glyph index and the advance. The last glyph's
+         // advance comes from the font. The others', from the positions.
+         for (int i = 0; i != glyph_count; ++i)
+         {
+            double advance_;
+            if (i + 1 != glyph_count)
+            {
+               advance_ = glyphs_[i+1].x - glyphs_[i].x;
+            }
+            else
+            {
+               cairo_text_extents_t extents;
+               cairo_scaled_font_glyph_extents(_scaled_font, glyphs_ + i, 1, &extents);
+               advance_ = extents.x_advance;
+            }
+            _glyph_store.push_back({ uint32_t(glyphs_[i].index), float(advance_) });
+         }
+
+         for (int i = 0; i != cluster_count; ++i)
+         {
+            _cluster_store.push_back({
+               uint8_t(clusters_[i].num_bytes), uint8_t(clusters_[i].num_glyphs)
+            });
+         }
+      }
+
+      if (glyphs_)
+         cairo_glyph_free(glyphs_);
+      if (clusters_)
+         cairo_text_cluster_free(clusters_);
+
+      if (!ok)
+      {
+         _glyph_store.clear();
+         _cluster_store.clear();
+         update();
          throw failed_to_build_master_glyphs{};
       }
    }
+
+   // Point the base glyphs to the stores
+   void master_glyphs::update()
+   {
+      _glyphs = _glyph_store.data();
+      _glyph_count = int(_glyph_store.size());
+      _clusters = _cluster_store.data();
+      _cluster_count = int(_cluster_store.size());
+   }
 }}
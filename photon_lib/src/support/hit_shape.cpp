@@ -0,0 +1,143 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/hit_shape.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      float distance_squared(point p, point c)
+      {
+         auto dx = p.x - c.x;
+         auto dy = p.y - c.y;
+         return dx*dx + dy*dy;
+      }
+
+      // Nonzero winding number of the closed polygon around p
+      int winding(std::vector<point> const& points, point p)
+      {
+         int w = 0;
+         for (std::size_t i = 0, n = points.size(); i != n; ++i)
+         {
+            auto a = points[i];
+            auto b = points[(i + 1) % n];
+            auto side = (b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y);
+            if (a.y <= p.y)
+            {
+               if (b.y > p.y && side > 0)
+                  ++w;
+            }
+            else if (b.y <= p.y && side < 0)
+            {
+               --w;
+            }
+         }
+         return w;
+      }
+   }
+
+   bool hit_shape::includes(point p) const
+   {
+      if (_kind == none || !_bounds.includes(p))
+         return false;
+
+      switch (_kind)
+      {
+         case rect_shape:
+            return true;
+
+         case round_rect_shape:
+         {
+            // Outside the corner squares, the bounds decide
+            auto r = _radius;
+            auto dx = std::max({ _bounds.left + r - p.x, p.x - (_bounds.right - r), 0.0f });
+            auto dy = std::max({ _bounds.top + r - p.y, p.y - (_bounds.bottom - r), 0.0f });
+            return dx*dx + dy*dy <= r*r;
+         }
+
+         case circle_shape:
+            return distance_squared(p, center_point(_bounds)) <= _radius * _radius;
+
+         case ring_shape:
+         {
+            auto d = distance_squared(p, center_point(_bounds));
+            return d <= _radius * _radius && d >= _inner_radius * _inner_radius;
+         }
+
+         case polygon_shape:
+            return winding(_points, p) != 0;
+
+         default:
+            return false;
+      }
+   }
+
+   hit_shape hit_shape::move(float dx, float dy) const
+   {
+      hit_shape r = *this;
+      r._bounds = _bounds.move(dx, dy);
+      for (auto& p : r._points)
+         p = p.move(dx, dy);
+      return r;
+   }
+
+   hit_shape hit_rect(rect r)
+   {
+      hit_shape s;
+      s._kind = hit_shape::rect_shape;
+      s._bounds = r;
+      return s;
+   }
+
+   hit_shape hit_round_rect(rect r, float radius)
+   {
+      hit_shape s;
+      s._kind = hit_shape::round_rect_shape;
+      s._bounds = r;
+      s._radius = std::max(0.0f, std::min({ radius, r.width() / 2, r.height() / 2 }));
+      return s;
+   }
+
+   hit_shape hit_circle(circle c)
+   {
+      hit_shape s;
+      s._kind = hit_shape::circle_shape;
+      s._bounds = c.bounds();
+      s._radius = c.radius;
+      return s;
+   }
+
+   hit_shape hit_ring(circle c, float inner_radius)
+   {
+      hit_shape s;
+      s._kind = hit_shape::ring_shape;
+      s._bounds = c.bounds();
+      s._radius = c.radius;
+      s._inner_radius = inner_radius;
+      return s;
+   }
+
+   hit_shape hit_polygon(std::vector<point> points)
+   {
+      hit_shape s;
+      if (points.size() < 3)
+         return s;
+
+      s._kind = hit_shape::polygon_shape;
+      rect b = { points[0].x, points[0].y, points[0].x, points[0].y };
+      for (auto p : points)
+      {
+         b.left = std::min(b.left, p.x);
+         b.top = std::min(b.top, p.y);
+         b.right = std::max(b.right, p.x);
+         b.bottom = std::max(b.bottom, p.y);
+      }
+      s._bounds = b;
+      s._points = std::move(points);
+      return s;
+   }
+}}
@@ -11,8 +11,195 @@
 #include <boost/filesystem.hpp>
 #include <string>
 
+#include <photon/support/detail/simd.hpp>
+#if !defined(CYCFI_PHOTON_SSE2) && defined(__ARM_NEON) && defined(__BYTE_ORDER__) \
+   && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+# include <arm_neon.h>
+# define PHOTON_PIXMAP_NEON
+#endif
+
 namespace cycfi { namespace photon
 {
+   namespace
+   {
+      // x * a / 255, rounded, exact for all 8 bit x and a
+      inline uint32_t mul_div255(uint32_t x, uint32_t a)
+      {
+         auto t = x * a + 128;
+         return (t + (t >> 8)) >> 8;
+      }
+
+#if defined(CYCFI_PHOTON_SSE2)
+      // Premultiply two BGRA pixels widened to 16 bits per channel. The
+      // alpha is multiplied by 255, leaving it as is.
+      inline __m128i premultiply(__m128i px)
+      {
+         auto a = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+         a = _mm_or_si128(a, _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+         auto t = _mm_add_epi16(_mm_mullo_epi16(px, a), _mm_set1_epi16(128));
+         return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+      }
+
+      // Premultiply four BGRA pixels, unless they are all opaque
+      inline __m128i premultiply_bgra(__m128i v)
+      {
+         auto const alpha = _mm_set1_epi32(0xFF000000);
+         auto opaque = _mm_cmpeq_epi32(_mm_and_si128(v, alpha), alpha);
+         if (_mm_movemask_epi8(opaque) == 0xFFFF)
+            return v;
+
+         auto const zero = _mm_setzero_si128();
+         return _mm_packus_epi16(
+            premultiply(_mm_unpacklo_epi8(v, zero))
+          , premultiply(_mm_unpackhi_epi8(v, zero))
+         );
+      }
+
+      // The kernels below convert whole blocks of pixels and return how
+      // many they did. Red and blue are swapped (RGBA to BGRA, which is
+      // ARGB32 on little endian) with shifts on SSE2, and with a byte
+      // shuffle on SSSE3 and AVX2.
+      std::size_t premultiply_sse2(uint8_t const* src, uint32_t* dest, std::size_t n)
+      {
+         auto const ga = _mm_set1_epi32(0xFF00FF00);
+         std::size_t i = 0;
+         for (; n - i >= 4; i += 4)
+         {
+            auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i*4));
+            auto rb = _mm_andnot_si128(ga, v);
+            v = _mm_or_si128(
+               _mm_and_si128(v, ga)
+             , _mm_or_si128(_mm_srli_epi32(rb, 16), _mm_slli_epi32(rb, 16))
+            );
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), premultiply_bgra(v));
+         }
+         return i;
+      }
+
+      CYCFI_PHOTON_TARGET("ssse3")
+      std::size_t premultiply_ssse3(uint8_t const* src, uint32_t* dest, std::size_t n)
+      {
+         auto const order = _mm_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+         std::size_t i = 0;
+         for (; n - i >= 4; i += 4)
+         {
+            auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i*4));
+            v = _mm_shuffle_epi8(v, order);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), premultiply_bgra(v));
+         }
+         return i;
+      }
+
+      CYCFI_PHOTON_TARGET("avx2")
+      inline __m256i premultiply(__m256i px)
+      {
+         auto a = _mm256_shufflehi_epi16(
+            _mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+         a = _mm256_or_si256(a, _mm256_setr_epi16(
+            0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255));
+         auto t = _mm256_add_epi16(_mm256_mullo_epi16(px, a), _mm256_set1_epi16(128));
+         return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+      }
+
+      CYCFI_PHOTON_TARGET("avx2")
+      std::size_t premultiply_avx2(uint8_t const* src, uint32_t* dest, std::size_t n)
+      {
+         auto const order = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+          , 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+         auto const alpha = _mm256_set1_epi32(0xFF000000);
+         auto const zero = _mm256_setzero_si256();
+
+         std::size_t i = 0;
+         for (; n - i >= 8; i += 8)
+         {
+            auto v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i*4));
+            v = _mm256_shuffle_epi8(v, order);
+
+            // Opaque pixels (all of them, for JPEGs) only need the swizzle
+            auto opaque = _mm256_cmpeq_epi32(_mm256_and_si256(v, alpha), alpha);
+            if (_mm256_movemask_epi8(opaque) != -1)
+            {
+               v = _mm256_packus_epi16(
+                  premultiply(_mm256_unpacklo_epi8(v, zero))
+                , premultiply(_mm256_unpackhi_epi8(v, zero))
+               );
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), v);
+         }
+         return i + premultiply_ssse3(src + i*4, dest + i, n - i);
+      }
+
+#elif defined(PHOTON_PIXMAP_NEON)
+      std::size_t premultiply_neon(uint8_t const* src, uint32_t* dest, std::size_t n)
+      {
+         std::size_t i = 0;
+         for (; n - i >= 16; i += 16)
+         {
+            auto px = vld4q_u8(src + i*4);  // Deinterleaved: r, g, b, a
+            auto a = px.val[3];
+
+            // (x * a + 128 + ((x * a + 128) >> 8)) >> 8, per channel
+            auto mul = [a](uint8x16_t x)
+            {
+               auto lo = vmull_u8(vget_low_u8(x), vget_low_u8(a));
+               auto hi = vmull_u8(vget_high_u8(x), vget_high_u8(a));
+               return vcombine_u8(
+                  vraddhn_u16(lo, vrshrq_n_u16(lo, 8))
+                , vraddhn_u16(hi, vrshrq_n_u16(hi, 8))
+               );
+            };
+
+            uint8x16x4_t out;
+            out.val[0] = mul(px.val[2]);  // blue
+            out.val[1] = mul(px.val[1]);  // green
+            out.val[2] = mul(px.val[0]);  // red
+            out.val[3] = a;
+            vst4q_u8(reinterpret_cast<uint8_t*>(dest + i), out);
+         }
+         return i;
+      }
+#endif
+   }
+
+   void premultiply_rgba(uint8_t const* src, uint32_t* dest, std::size_t n)
+   {
+#if defined(CYCFI_PHOTON_SSE2)
+      std::size_t i =
+         detail::has_avx2()? premultiply_avx2(src, dest, n) :
+         detail::has_ssse3()? premultiply_ssse3(src, dest, n) :
+         premultiply_sse2(src, dest, n)
+         ;
+#elif defined(PHOTON_PIXMAP_NEON)
+      std::size_t i = premultiply_neon(src, dest, n);
+#else
+      std::size_t i = 0;
+#endif
+
+      // The rest, one pixel at a time. Writing whole words keeps this
+      // correct on any endian.
+      for (; i != n; ++i)
+      {
+         auto p = src + i*4;
+         uint32_t a = p[3];
+         if (a == 255)
+         {
+            dest[i] = 0xFF000000 | (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+         }
+         else
+         {
+            dest[i] =
+               (a << 24)
+             | (mul_div255(p[0], a) << 16)
+             | (mul_div255(p[1], a) << 8)
+             | mul_div255(p[2], a)
+             ;
+         }
+      }
+   }
+
    pixmap::pixmap(point size, float scale)
     : _surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size.x, size.y))
    {
@@ -49,6 +236,7 @@ namespace cycfi { namespace photon
          if (src_data)
          {
             _surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+            cairo_surface_flush(_surface);
 
             uint8_t* dest_data = cairo_image_surface_get_data(_surface);
             size_t   src_stride = w * 4;
@@ -56,20 +244,11 @@ namespace cycfi { namespace photon
 
             for (size_t y = 0; y != h; ++y)
             {
-               uint8_t* src = src_data + (y * src_stride);
-               uint8_t* dest = dest_data + (y * dest_stride);
-               for (size_t x = 0; x != w; ++x)
-               {
-                  // $$$ TODO: Deal with endian issues $$$
-
-                  dest[0] = src[2];    // blue
-                  dest[1] = src[1];    // green
-                  dest[2] = src[0];    // red
-                  dest[3] = src[3];    // alpha
-
-                  src += 4;
-                  dest += 4;
-               }
+               premultiply_rgba(
+                  src_data + (y * src_stride)
+                , reinterpret_cast<uint32_t*>(dest_data + (y * dest_stride))
+                , w
+               );
             }
 
             stbi_image_free(src_data);
@@ -0,0 +1,169 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/pixmap_registry.hpp>
+#include <photon/support/canvas.hpp>
+#include <boost/filesystem.hpp>
+#include <cmath>
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      std::size_t decoded_bytes(pixmap const& pm)
+      {
+         return std::size_t(cairo_image_surface_get_stride(pm._surface))
+            * cairo_image_surface_get_height(pm._surface);
+      }
+   }
+
+   constexpr std::size_t pixmap_registry::default_budget;
+
+   pixmap_registry::pixmap_registry(std::size_t budget)
+    : _budget(budget)
+   {}
+
+   pixmap_ptr pixmap_registry::get(char const* filename, float scale)
+   {
+      // The same file, however it is spelled relative to the current path
+      auto key = key_type{ boost::filesystem::absolute(filename).string(), scale };
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         auto i = _entries.find(key);
+         if (i != _entries.end())
+         {
+            ++_stats.hits;
+            _lru.splice(_lru.begin(), _lru, i->second.lru);
+            return i->second.pixmap;
+         }
+         ++_stats.misses;
+      }
+
+      // Decode without holding the lock. If another thread got to the same
+      // file in the meantime, keep the one that came in first.
+      auto pm = std::make_shared<pixmap>(filename, scale);
+      auto bytes = decoded_bytes(*pm);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto r = _entries.emplace(key, entry{ pm, bytes, {} });
+      if (!r.second)
+         return r.first->second.pixmap;
+
+      _lru.push_front(key);
+      r.first->second.lru = _lru.begin();
+      _stats.bytes += bytes;
+      ++_stats.entries;
+      trim(_budget);
+      return pm;
+   }
+
+   pixmap_ptr pixmap_registry::prescaled(
+      pixmap_ptr const& source, int variant
+    , point size, float scale, draw_function f
+   )
+   {
+      auto key = prescaled_key{ source.get(), variant, size.x, size.y, scale };
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         auto i = _prescaled.find(key);
+         if (i != _prescaled.end())
+         {
+            if (i->second.source.lock() == source)
+            {
+               ++_stats.hits;
+               _prescaled_lru.splice(_prescaled_lru.begin(), _prescaled_lru, i->second.lru);
+               return i->second.pixmap;
+            }
+
+            // Made from an earlier pixmap at the same address
+            _stats.bytes -= i->second.bytes;
+            --_stats.entries;
+            _prescaled_lru.erase(i->second.lru);
+            _prescaled.erase(i);
+         }
+         ++_stats.misses;
+      }
+
+      auto w = std::ceil(size.x * scale);
+      auto h = std::ceil(size.y * scale);
+      auto pm = std::make_shared<pixmap>(point{ w, h }, 1 / scale);
+      {
+         pixmap_context pm_ctx{ *pm };
+         canvas cnv{ *pm_ctx.context() };
+         f(cnv, { 0, 0, size.x, size.y });
+      }
+      cairo_surface_flush(pm->_surface);
+      auto bytes = decoded_bytes(*pm);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto r = _prescaled.emplace(key, prescaled_entry{ source, pm, bytes, {} });
+      if (!r.second)
+         return r.first->second.pixmap;
+
+      _prescaled_lru.push_front(key);
+      r.first->second.lru = _prescaled_lru.begin();
+      _stats.bytes += bytes;
+      ++_stats.entries;
+      trim(_budget);
+      return pm;
+   }
+
+   std::size_t pixmap_registry::budget() const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _budget;
+   }
+
+   void pixmap_registry::budget(std::size_t bytes)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _budget = bytes;
+      trim(_budget);
+   }
+
+   pixmap_registry::statistics pixmap_registry::stats() const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _stats;
+   }
+
+   void pixmap_registry::clear()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      trim(0);
+   }
+
+   template <typename Map, typename List>
+   void pixmap_registry::trim(Map& entries, List& lru, std::size_t budget)
+   {
+      // Oldest first, skipping the pixmaps someone else holds
+      for (auto i = lru.end(); i != lru.begin() && _stats.bytes > budget;)
+      {
+         --i;
+         auto e = entries.find(*i);
+         if (e->second.pixmap.use_count() > 1)
+            continue;
+
+         _stats.bytes -= e->second.bytes;
+         --_stats.entries;
+         ++_stats.evictions;
+         entries.erase(e);
+         i = lru.erase(i);
+      }
+   }
+
+   void pixmap_registry::trim(std::size_t budget)
+   {
+      // Prescaled copies are cheaper to make again than decoding files
+      trim(_prescaled, _prescaled_lru, budget);
+      trim(_entries, _lru, budget);
+   }
+
+   pixmap_registry& get_pixmap_registry()
+   {
+      static pixmap_registry registry;
+      return registry;
+   }
+}}
@@ -0,0 +1,278 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/shadow.hpp>
+#include <photon/support/pixmap.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      using mask_buffer = std::vector<uint8_t>;
+      using pattern_ptr = std::shared_ptr<cairo_pattern_t>;
+
+      // One box blur pass down the columns of src (w x h bytes), written to
+      // dest. Whole rows are summed at a time: the inner loops have no
+      // dependencies across x, so the compiler turns them into vector code.
+      void box_blur_columns(uint8_t const* src, uint8_t* dest, int w, int h, int r)
+      {
+         std::vector<uint32_t> sum(w, 0);
+         uint32_t const scale = (1 << 16) / (2*r + 1);
+
+         for (int y = 0; y < h + r; ++y)
+         {
+            if (y < h)
+            {
+               auto row = src + y*w;
+               for (int x = 0; x < w; ++x)
+                  sum[x] += row[x];
+            }
+
+            // The window of output row y-r is rows y-2r to y
+            if (y >= r)
+            {
+               auto out = dest + (y-r)*w;
+               for (int x = 0; x < w; ++x)
+                  out[x] = (sum[x] * scale + (1 << 15)) >> 16;
+            }
+
+            if (y >= 2*r && y-2*r < h)
+            {
+               auto row = src + (y-2*r)*w;
+               for (int x = 0; x < w; ++x)
+                  sum[x] -= row[x];
+            }
+         }
+      }
+
+      void transpose(uint8_t const* src, uint8_t* dest, int w, int h)
+      {
+         for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+               dest[x*h + y] = src[y*w + x];
+      }
+
+      // Three box blur passes each way. The rows are blurred as columns of
+      // the transposed mask.
+      void blur(mask_buffer& mask, int w, int h, int r)
+      {
+         mask_buffer tmp(mask.size());
+         for (int i = 0; i != 3; ++i)
+         {
+            box_blur_columns(mask.data(), tmp.data(), w, h, r);
+            mask.swap(tmp);
+         }
+
+         transpose(mask.data(), tmp.data(), w, h);
+         mask.swap(tmp);
+         for (int i = 0; i != 3; ++i)
+         {
+            box_blur_columns(mask.data(), tmp.data(), h, w, r);
+            mask.swap(tmp);
+         }
+         transpose(mask.data(), tmp.data(), h, w);
+         mask.swap(tmp);
+      }
+
+      // Render the shadow of a shape_w x shape_h round rect (in pixels),
+      // blurred with box radius r, in color c. The shadow spreads 3*r
+      // pixels past the shape on all sides.
+      pixmap render_shadow(int shape_w, int shape_h, float radius, int r, color c)
+      {
+         int const e = 3*r;
+         int const w = shape_w + 2*e;
+         int const h = shape_h + 2*e;
+
+         // The A8 mask. The rows are padded to cairo's stride, and the
+         // padding is blurred along as extra columns.
+         int const stride = cairo_format_stride_for_width(CAIRO_FORMAT_A8, w);
+         mask_buffer mask(stride * h, 0);
+         {
+            auto surface = cairo_image_surface_create_for_data(
+               mask.data(), CAIRO_FORMAT_A8, w, h, stride);
+            auto context = cairo_create(surface);
+            {
+               canvas cnv{ *context };
+               cnv.round_rect({ float(e), float(e), float(e + shape_w), float(e + shape_h) }, radius);
+               cnv.fill_style(colors::black);
+               cnv.fill();
+            }
+            cairo_destroy(context);
+            cairo_surface_finish(surface);
+            cairo_surface_destroy(surface);
+         }
+         blur(mask, stride, h, r);
+
+         // Color it, premultiplied, in native endian ARGB
+         uint32_t lut[256];
+         for (int a = 0; a != 256; ++a)
+         {
+            auto alpha = c.alpha * a / 255;
+            lut[a] =
+               (uint32_t(std::lround(alpha * 255)) << 24) |
+               (uint32_t(std::lround(c.red * alpha * 255)) << 16) |
+               (uint32_t(std::lround(c.green * alpha * 255)) << 8) |
+               uint32_t(std::lround(c.blue * alpha * 255))
+               ;
+         }
+
+         pixmap pm{ point(w, h) };
+         cairo_surface_flush(pm._surface);
+         auto data = cairo_image_surface_get_data(pm._surface);
+         auto pm_stride = cairo_image_surface_get_stride(pm._surface);
+         for (int y = 0; y < h; ++y)
+         {
+            auto src = mask.data() + y*stride;
+            auto dest = reinterpret_cast<uint32_t*>(data + y*pm_stride);
+            for (int x = 0; x < w; ++x)
+               dest[x] = lut[src[x]];
+         }
+         cairo_surface_mark_dirty(pm._surface);
+         return pm;
+      }
+
+      // A pattern for the src part of the image, padded at the edges so
+      // stretching it does not bleed in its neighbors.
+      pattern_ptr make_patch(pixmap const& pm, int left, int top, int w, int h)
+      {
+         auto sub = cairo_surface_create_for_rectangle(pm._surface, left, top, w, h);
+         auto pat = cairo_pattern_create_for_surface(sub);
+         cairo_surface_destroy(sub);
+         cairo_pattern_set_extend(pat, CAIRO_EXTEND_PAD);
+         return pattern_ptr(pat, cairo_pattern_destroy);
+      }
+
+      void blit(cairo_t& context, cairo_pattern_t* pat, float w, float h, rect dest)
+      {
+         if (dest.width() <= 0 || dest.height() <= 0)
+            return;
+
+         cairo_matrix_t m;
+         cairo_matrix_init_scale(&m, w / dest.width(), h / dest.height());
+         cairo_matrix_translate(&m, -dest.left, -dest.top);
+         cairo_pattern_set_matrix(pat, &m);
+         cairo_set_source(&context, pat);
+         cairo_rectangle(&context, dest.left, dest.top, dest.width(), dest.height());
+         cairo_fill(&context);
+      }
+
+      // The shadow of a square with side 2*(k-e)+1 pixels. Its middle row
+      // and column are not touched by the corners, so the image splits
+      // into k x k corners, 1 pixel wide edges and a 1 pixel middle.
+      struct nine_patch
+      {
+         nine_patch(float radius, int r, int k, color c)
+          : image(render_shadow(2*(k-3*r)+1, 2*(k-3*r)+1, radius, r, c))
+          , k(k)
+         {
+            int const pos[] = { 0, k, k+1, 2*k+1 };
+            for (int j = 0; j != 3; ++j)
+               for (int i = 0; i != 3; ++i)
+                  patches[j*3 + i] = make_patch(
+                     image, pos[i], pos[j], pos[i+1]-pos[i], pos[j+1]-pos[j]);
+         }
+
+         pixmap         image;
+         int            k;
+         pattern_ptr    patches[9];
+      };
+
+      // The shadow of a shape too small for the nine-patch, drawn as is
+      struct small_shadow
+      {
+         small_shadow(int w, int h, float radius, int r, color c)
+          : image(render_shadow(w, h, radius, r, c))
+          , pattern(make_patch(image, 0, 0, w + 6*r, h + 6*r))
+         {}
+
+         pixmap         image;
+         pattern_ptr    pattern;
+      };
+
+      using shadow_key = std::tuple<float, float, float, float, float, float, float>;
+      using small_shadow_key = std::tuple<shadow_key, int, int>;
+      constexpr std::size_t shadow_cache_size = 32;
+
+      // Per thread, like the canvases using it. It simply starts over when
+      // full.
+      template <typename T, typename Key, typename... Args>
+      T const& get_cached(Key const& key, Args... args)
+      {
+         thread_local std::map<Key, std::unique_ptr<T>> cache;
+         auto i = cache.find(key);
+         if (i != cache.end())
+            return *i->second;
+
+         if (cache.size() >= shadow_cache_size)
+            cache.clear();
+
+         auto& p = cache[key];
+         p.reset(new T{ args... });
+         return *p;
+      }
+
+      // The device scale, rounded so that animated transforms do not
+      // render a new shadow per frame.
+      float rounded_scale(canvas& cnv)
+      {
+         return std::max(0.25f, std::round(cnv.device_scale() * 4) / 4);
+      }
+   }
+
+   void draw_shadow(
+      canvas& cnv, rect bounds
+    , float corner_radius, float blur, color c
+   )
+   {
+      if (bounds.width() <= 0 || bounds.height() <= 0 || c.alpha <= 0)
+         return;
+
+      auto& context = cnv.cairo_context();
+      auto const scale = rounded_scale(cnv);
+      auto const radius = corner_radius * scale;
+      int const r = std::max(1, int(std::lround(blur * scale / 3)));
+      int const e = 3*r;
+      int const k = e + int(std::ceil(radius)) + e;
+      auto const outer = bounds.inset(-e / scale, -e / scale);
+
+      auto state = cnv.new_state();
+
+      // Abutting patches must not blend at their seams
+      cairo_set_antialias(&context, CAIRO_ANTIALIAS_NONE);
+
+      auto key = shadow_key{ corner_radius, blur, c.red, c.green, c.blue, c.alpha, scale };
+
+      // Too small for the nine-patch. Render this one as is.
+      if (bounds.width() * scale < 2*(k-e) || bounds.height() * scale < 2*(k-e))
+      {
+         int w = std::ceil(bounds.width() * scale);
+         int h = std::ceil(bounds.height() * scale);
+         auto const& s = get_cached<small_shadow>(small_shadow_key{ key, w, h }, w, h, radius, r, c);
+         blit(context, s.pattern.get(), w + 2*e, h + 2*e, outer);
+         return;
+      }
+
+      auto const& np = get_cached<nine_patch>(key, radius, r, k, c);
+
+      float const xs[] = { outer.left, outer.left + k/scale, outer.right - k/scale, outer.right };
+      float const ys[] = { outer.top, outer.top + k/scale, outer.bottom - k/scale, outer.bottom };
+      int const pos[] = { 0, k, k+1, 2*k+1 };
+
+      for (int j = 0; j != 3; ++j)
+         for (int i = 0; i != 3; ++i)
+            blit(
+               context, np.patches[j*3 + i].get()
+             , pos[i+1]-pos[i], pos[j+1]-pos[j]
+             , { xs[i], ys[j], xs[i+1], ys[j+1] }
+            );
+   }
+}}
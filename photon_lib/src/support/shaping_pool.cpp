@@ -0,0 +1,67 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/shaping_pool.hpp>
+
+namespace cycfi { namespace photon
+{
+   ////////////////////////////////////////////////////////////////////////////
+   shaped_text::shaped_text(
+      std::string text_
+    , char const* face, float size, int style, float scale
+   )
+    : text(std::move(text_))
+    , glyphs(text.data(), text.data() + text.size(), face, size, style, scale)
+   {}
+
+   shaped_text::shaped_text(shaped_text&& rhs)
+    : text(std::move(rhs.text))
+    , glyphs(std::move(rhs.glyphs))
+   {
+      // Short text lives inside the string itself and does not keep its
+      // address when moved.
+      if (glyphs.begin() != text.data())
+         glyphs.rebind(text.data(), text.data() + text.size());
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   shaping_pool::shaping_pool(std::size_t num_threads)
+    : _pool(num_threads)
+   {}
+
+   std::future<shaped_text> shaping_pool::shape(
+      std::string text
+    , char const* face, float size, int style, float scale
+   )
+   {
+      // std::function wants a copyable target, hence the shared_ptr.
+      auto t = std::make_shared<std::packaged_task<shaped_text()>>(
+         [text = std::move(text), face = std::string(face), size, style, scale]() mutable
+         {
+            return shaped_text{ std::move(text), face.c_str(), size, style, scale };
+         }
+      );
+      auto result = t->get_future();
+      _pool.post([t]{ (*t)(); });
+      return result;
+   }
+
+   std::vector<shaped_text> shaping_pool::shape_all(
+      std::vector<std::string> texts
+    , char const* face, float size, int style, float scale
+   )
+   {
+      std::vector<std::future<shaped_text>> futures;
+      futures.reserve(texts.size());
+      for (auto& text : texts)
+         futures.push_back(shape(std::move(text), face, size, style, scale));
+
+      std::vector<shaped_text> result;
+      result.reserve(futures.size());
+      for (auto& f : futures)
+         result.push_back(f.get());
+      return result;
+   }
+}}
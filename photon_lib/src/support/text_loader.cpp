@@ -0,0 +1,234 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/text_loader.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# define PHOTON_HAS_MMAP
+#endif
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      constexpr std::size_t chunk_size = 64 * 1024;
+      constexpr std::size_t max_block_size = 4 * chunk_size;
+
+      ////////////////////////////////////////////////////////////////////////
+      // file_source: Reads a file chunk by chunk, from a memory mapping where
+      // available, or else from a plain stream.
+      ////////////////////////////////////////////////////////////////////////
+      class file_source
+      {
+      public:
+
+         explicit file_source(char const* path)
+         {
+#if defined(PHOTON_HAS_MMAP)
+            _fd = ::open(path, O_RDONLY);
+            struct stat st;
+            if (_fd != -1 && ::fstat(_fd, &st) == 0 && st.st_size > 0)
+            {
+               _size = std::size_t(st.st_size);
+               void* map = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+               if (map != MAP_FAILED)
+               {
+                  _map = static_cast<char const*>(map);
+                  ::madvise(map, _size, MADV_SEQUENTIAL);
+                  return;
+               }
+            }
+#endif
+            _file.open(path, std::ios::binary);
+            if (_file)
+            {
+               _file.seekg(0, std::ios::end);
+               _size = std::size_t(_file.tellg());
+               _file.seekg(0, std::ios::beg);
+            }
+         }
+
+         ~file_source()
+         {
+#if defined(PHOTON_HAS_MMAP)
+            if (_map)
+               ::munmap(const_cast<char*>(_map), _size);
+            if (_fd != -1)
+               ::close(_fd);
+#endif
+         }
+
+         bool is_open() const
+         {
+            return _map || _file.is_open();
+         }
+
+         std::size_t size() const
+         {
+            return _size;
+         }
+
+         // Append the next chunk to text. Returns false at the end.
+         bool read(std::string& text)
+         {
+            auto n = std::min(chunk_size, _size - _pos);
+            if (n == 0)
+               return false;
+
+            if (_map)
+            {
+               text.append(_map + _pos, n);
+            }
+            else
+            {
+               char buff[chunk_size];
+               _file.read(buff, n);
+               n = std::size_t(_file.gcount());
+               if (n == 0)
+                  return false;
+               text.append(buff, n);
+            }
+            _pos += n;
+            return true;
+         }
+
+      private:
+
+#if defined(PHOTON_HAS_MMAP)
+         int            _fd = -1;
+#endif
+         char const*    _map = nullptr;
+         std::ifstream  _file;
+         std::size_t    _size = 0;
+         std::size_t    _pos = 0;
+      };
+
+      // Where to end the block that starts at first: just before the last
+      // newline, so the next block starts a new paragraph.
+      char const* block_end(char const* first, char const* last, bool at_end)
+      {
+         if (at_end)
+            return last;
+         if (last - first < 2)
+            return first;
+
+         for (auto i = last; i != first + 1; --i)
+         {
+            if (i[-1] == '\n')
+               return i - 1;
+         }
+
+         // No newline in sight. Split a very long line at a UTF-8 boundary
+         // (before the last lead byte, which may not be complete yet).
+         if (std::size_t(last - first) < max_block_size)
+            return first;
+         auto i = last - 1;
+         while (i != first && (uint8_t(*i) & 0xC0) == 0x80)
+            --i;
+         return i;
+      }
+   }
+
+   text_loader::block::block(
+      char const* first, char const* last
+    , master_glyphs const& font, float width_
+   )
+    : glyphs(first, last, font)
+    , width(width_)
+   {
+      if (width > 0)
+         glyphs.break_lines(width, rows);
+   }
+
+   text_loader::text_loader(char const* path, master_glyphs const& font)
+    : _cancel(false)
+    , _done(false)
+    , _failed(false)
+    , _width(-1)
+    , _size(0)
+    , _font(font.begin(), font.begin(), font)
+    , _thread(&text_loader::load, this, std::string(path))
+   {}
+
+   text_loader::~text_loader()
+   {
+      _cancel = true;
+      _thread.join();
+   }
+
+   void text_loader::poll(std::vector<block_ptr>& blocks)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      blocks.insert(blocks.end(), _ready.begin(), _ready.end());
+      _ready.clear();
+   }
+
+   void text_loader::add_block(char const* first, char const* last)
+   {
+      auto b = std::make_shared<block>(first, last, _font, _width);
+      _blocks.push_back(b);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _ready.push_back(std::move(b));
+   }
+
+   void text_loader::load(std::string path)
+   {
+      try
+      {
+         file_source file{ path.c_str() };
+         if (!file.is_open())
+         {
+            _failed = true;
+            _done = true;
+            return;
+         }
+
+         // Reserve everything up front. The blocks point into _text while
+         // it is still growing, so it must never reallocate.
+         _size = file.size();
+         _text.reserve(_size);
+
+         std::size_t start = 0;
+         bool        more = true;
+         while (more && !_cancel)
+         {
+            more = file.read(_text);
+            auto first = _text.data() + start;
+            auto last = _text.data() + _text.size();
+            auto end = block_end(first, last, !more);
+            if (end != first)
+            {
+               add_block(first, end);
+               start = end - _text.data();
+            }
+         }
+
+         if (_cancel)
+            return;
+
+         std::vector<master_glyphs const*> parts;
+         parts.reserve(_blocks.size() + 1);
+         parts.push_back(&_font);
+         for (auto const& b : _blocks)
+            parts.push_back(&b->glyphs);
+
+         _glyphs.reset(
+            new master_glyphs(_text.data(), _text.data() + _text.size(), parts));
+      }
+      catch (...)
+      {
+         _failed = true;
+      }
+      _done = true;
+   }
+}}
@@ -6,19 +6,195 @@
 #include <photon/support/text_utils.hpp>
 #include <photon/support/misc.hpp>
 #include <photon/support/theme.hpp>
+#include <photon/support/icon_ids.hpp>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <cstring>
+
+#include <photon/support/detail/simd.hpp>
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
 
 namespace cycfi { namespace photon
 {
+   namespace
+   {
+      struct icon_key
+      {
+         bool operator==(icon_key const& rhs) const
+         {
+            return code == rhs.code && size == rhs.size
+               && c == rhs.c && scale == rhs.scale;
+         }
+
+         uint32_t    code;
+         float       size;
+         color       c;
+         float       scale;
+      };
+
+      struct icon_key_hash
+      {
+         std::size_t operator()(icon_key const& key) const
+         {
+            std::size_t h = key.code;
+            for (float f : { key.size, key.c.red, key.c.green, key.c.blue, key.c.alpha, key.scale })
+               h = (h * 31) ^ std::hash<float>{}(f);
+            return h;
+         }
+      };
+
+      struct icon_raster
+      {
+         photon::pixmap    pixmap;
+         point             offset;  // top-left, relative to the icon center
+      };
+
+      using icon_ptr = std::shared_ptr<icon_raster const>;
+      using icon_cache_map = std::unordered_map<icon_key, icon_ptr, icon_key_hash>;
+
+      // Guard against unbounded growth (e.g. animated icon colors)
+      constexpr std::size_t max_cached_icons = 1024;
+
+      // Tile workers draw icons too, so the cache is locked. Icons are
+      // handed out by shared_ptr: clearing the cache does not pull one
+      // from under a draw in progress.
+      struct icon_cache_type
+      {
+         std::mutex        mutex;
+         icon_cache_map    map;
+      };
+
+      icon_cache_type& icon_cache()
+      {
+         static icon_cache_type cache;
+         return cache;
+      }
+
+      // Pixels per user unit, taking into account both the current
+      // transform and the device scale of the target surface. Returns 0
+      // if the transform rotates, skews or scales non-uniformly: we do not
+      // cache those and render the glyph directly instead.
+      float pixel_scale(canvas& cnv, cairo_matrix_t& m, double& dscale)
+      {
+         auto& cr = cnv.cairo_context();
+         cairo_get_matrix(&cr, &m);
+         if (m.xy != 0 || m.yx != 0 || m.xx != m.yy || m.xx <= 0)
+            return 0;
+
+         double sx, sy;
+         cairo_surface_get_device_scale(cairo_get_target(&cr), &sx, &sy);
+         if (sx != sy)
+            return 0;
+         dscale = sx;
+         return cnv.device_scale();
+      }
+
+      icon_raster rasterize_icon(icon_key const& key)
+      {
+         auto& thm = get_theme();
+         auto  utf8 = codepoint_to_utf8(key.code);
+
+         // Measure the glyph
+         auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+         auto context_ = cairo_create(surface_);
+         canvas mcnv{ *context_ };
+         mcnv.custom_font(thm.icon_font, key.size);
+
+         cairo_text_extents_t extents;
+         cairo_text_extents(context_, utf8.c_str(), &extents);
+         cairo_font_extents_t font_extents;
+         cairo_font_extents(context_, &font_extents);
+
+         // Render the glyph's ink box (plus one pixel of padding for
+         // antialiasing) into its own pixmap
+         float pad = 1 / key.scale;
+         point size_px = {
+            std::ceil(float(extents.width) * key.scale) + 2
+          , std::ceil(float(extents.height) * key.scale) + 2
+         };
+
+         icon_raster r{ photon::pixmap{ size_px, 1 / key.scale }, {} };
+         {
+            pixmap_context pctx{ r.pixmap };
+            auto cr = pctx.context();
+            cairo_set_font_face(cr, cairo_get_font_face(context_));
+            cairo_set_font_size(cr, key.size);
+            cairo_set_source_rgba(cr, key.c.red, key.c.green, key.c.blue, key.c.alpha);
+            cairo_move_to(cr, pad - extents.x_bearing, pad - extents.y_bearing);
+            cairo_show_text(cr, utf8.c_str());
+         }
+
+         // Place the ink box exactly where canvas::fill_text would have
+         // placed it with (middle | center) alignment
+         r.offset = {
+            float(extents.x_bearing - extents.width/2) - pad
+          , float(font_extents.ascent/2 - font_extents.descent/2 + extents.y_bearing) - pad
+         };
+
+         cairo_surface_destroy(surface_);
+         cairo_destroy(context_);
+         return r;
+      }
+
+      icon_ptr get_icon(icon_key const& key)
+      {
+         auto& cache = icon_cache();
+         {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto i = cache.map.find(key);
+            if (i != cache.map.end())
+               return i->second;
+         }
+
+         // Rasterize outside the lock. If two threads race for the same
+         // icon, the first one in wins.
+         auto icon = std::make_shared<icon_raster const>(rasterize_icon(key));
+
+         std::lock_guard<std::mutex> lock(cache.mutex);
+         if (cache.map.size() >= max_cached_icons)
+            cache.map.clear();
+         return cache.map.emplace(key, std::move(icon)).first->second;
+      }
+   }
+
    void draw_icon(canvas& cnv, rect bounds, uint32_t code, float size, color c)
    {
-      auto  state = cnv.new_state();
-      auto& thm = get_theme();
       float cx = bounds.left + (bounds.width() / 2);
       float cy = bounds.top + (bounds.height() / 2);
-      cnv.custom_font(thm.icon_font, size);
-      cnv.fill_style(c);
-      cnv.text_align(cnv.middle | cnv.center);
-      cnv.fill_text(point{ cx, cy }, codepoint_to_utf8(code).c_str());
+
+      cairo_matrix_t m;
+      double dscale = 1;
+      float scale = pixel_scale(cnv, m, dscale);
+
+      if (scale == 0)
+      {
+         auto  state = cnv.new_state();
+         auto& thm = get_theme();
+         cnv.custom_font(thm.icon_font, size);
+         cnv.fill_style(c);
+         cnv.text_align(cnv.middle | cnv.center);
+         cnv.fill_text(point{ cx, cy }, codepoint_to_utf8(code).c_str());
+         return;
+      }
+
+      auto icon_ = get_icon({ code, size, c, scale });
+
+      // Snap to device pixels so the blit is not resampled
+      auto snap = [&](float v, double offset)
+      {
+         double px = std::round((m.xx * v + offset) * dscale);
+         return float((px / dscale - offset) / m.xx);
+      };
+
+      point pos = {
+         snap(cx + icon_->offset.x, m.x0)
+       , snap(cy + icon_->offset.y, m.y0)
+      };
+      cnv.draw(icon_->pixmap, pos);
    }
 
    void draw_icon(canvas& cnv, rect bounds, uint32_t code, float size)
@@ -26,6 +202,29 @@ namespace cycfi { namespace photon
       draw_icon(cnv, bounds, code, size, get_theme().icon_color);
    }
 
+   void prewarm_icons(
+      uint32_t const codes[], std::size_t num_codes
+    , float size, color c, float scale
+   )
+   {
+      for (std::size_t i = 0; i != num_codes; ++i)
+         get_icon({ codes[i], size, c, scale });
+   }
+
+   void prewarm_icons(float scale)
+   {
+      auto& thm = get_theme();
+      for (uint32_t code = icons::first; code <= icons::last; ++code)
+         get_icon({ code, thm.icon_font_size, thm.icon_color, scale });
+   }
+
+   void clear_icon_cache()
+   {
+      auto& cache = icon_cache();
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      cache.map.clear();
+   }
+
    point measure_icon(canvas& cnv, uint32_t cp, float size)
    {
       auto  state = cnv.new_state();
@@ -75,4 +274,155 @@ namespace cycfi { namespace photon
       detail::codepoint_to_utf8(codepoint, &result[0]);
       return result;
    }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Bulk UTF8 scanning
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      inline unsigned count_trailing_zeros(unsigned mask)
+      {
+#if defined(_MSC_VER)
+         unsigned long index;
+         _BitScanForward(&index, mask);
+         return index;
+#else
+         return __builtin_ctz(mask);
+#endif
+      }
+
+      // ASCII break properties, local to this module so the bulk decoder
+      // can inline the lookup
+      struct ascii_break_properties
+      {
+         ascii_break_properties()
+         {
+            for (unsigned c = 0; c != 128; ++c)
+               props[c] = break_properties(c);
+         }
+
+         uint16_t props[128];
+      };
+
+      ascii_break_properties const ascii_props;
+
+      inline decoded_codepoint decoded(char const* pos, unsigned cp, uint16_t props)
+      {
+         return {
+            pos, cp, unsigned(props >> 11)
+          , line_break_class(props & 0x3F)
+          , word_break_class((props >> 6) & 0x1F)
+         };
+      }
+   }
+
+#if defined(CYCFI_PHOTON_SSE2)
+   namespace
+   {
+      // Skip 32 bytes at a time, up to the first block that is not all
+      // ASCII, or to the tail
+      CYCFI_PHOTON_TARGET("avx2")
+      char const* skip_ascii_avx2(char const* first, char const* last)
+      {
+         for (; last - first >= 32; first += 32)
+         {
+            auto v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+            if (_mm256_movemask_epi8(v))
+               break;
+         }
+         return first;
+      }
+   }
+#endif
+
+   char const* find_non_ascii(char const* first, char const* last)
+   {
+#if defined(CYCFI_PHOTON_SSE2)
+      if (detail::has_avx2())
+         first = skip_ascii_avx2(first, last);
+
+      for (; last - first >= 16; first += 16)
+      {
+         auto v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+         if (auto mask = unsigned(_mm_movemask_epi8(v)))
+            return first + count_trailing_zeros(mask);
+      }
+#else
+      for (; last - first >= 8; first += 8)
+      {
+         uint64_t word;
+         std::memcpy(&word, first, 8);
+         if (word & 0x8080808080808080ull)
+            break;
+      }
+#endif
+      for (; first != last; ++first)
+      {
+         if (uint8_t(*first) & 0x80)
+            return first;
+      }
+      return last;
+   }
+
+   char const* validate_utf8(char const* first, char const* last)
+   {
+      unsigned    state = utf8_accept;
+      unsigned    cp;
+      char const* start = first;
+
+      while (first != last)
+      {
+         if (state == utf8_accept)
+         {
+            if (uint8_t(*first) < 0x80)
+            {
+               first = find_non_ascii(first, last);
+               if (first == last)
+                  break;
+            }
+            start = first;
+         }
+         if (decode_utf8(state, cp, uint8_t(*first++)) == utf8_reject)
+            return start;
+      }
+      return (state == utf8_accept) ? last : start;
+   }
+
+   std::size_t decode_utf8(
+      char const*& first, char const* last
+    , decoded_codepoint out[], std::size_t max
+   )
+   {
+      std::size_t n = 0;
+      while (n != max && first != last)
+      {
+         // The ASCII run, if any
+         auto size = std::min<std::size_t>(last - first, max - n);
+         auto ascii_last = find_non_ascii(first, first + size);
+         for (; first != ascii_last; ++first, ++n)
+         {
+            auto c = uint8_t(*first);
+            out[n] = decoded(first, c, ascii_props.props[c]);
+         }
+
+         if (n == max || first == last)
+            break;
+
+         // One non-ASCII codepoint
+         unsigned    state = utf8_accept;
+         unsigned    cp;
+         char const* pos = first;
+         do
+            decode_utf8(state, cp, uint8_t(*first++));
+         while (state != utf8_accept && state != utf8_reject && first != last);
+
+         if (state != utf8_accept)
+         {
+            cp = 0xFFFD;
+            first = pos + 1;
+         }
+         out[n++] = decoded(pos, cp, break_properties(cp));
+      }
+      return n;
+   }
 }}
@@ -0,0 +1,57 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/thread_pool.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace photon
+{
+   thread_pool::thread_pool(std::size_t num_threads)
+   {
+      if (num_threads == 0)
+         num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+      _threads.reserve(num_threads);
+      for (std::size_t i = 0; i != num_threads; ++i)
+         _threads.emplace_back(&thread_pool::run, this);
+   }
+
+   thread_pool::~thread_pool()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _ready.notify_all();
+      for (auto& t : _threads)
+         t.join();
+   }
+
+   void thread_pool::post(task t)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _tasks.push_back(std::move(t));
+      }
+      _ready.notify_one();
+   }
+
+   void thread_pool::run()
+   {
+      for (;;)
+      {
+         task t;
+         {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _ready.wait(lock, [this]{ return _stop || !_tasks.empty(); });
+            if (_tasks.empty())
+               return;
+            t = std::move(_tasks.front());
+            _tasks.pop_front();
+         }
+         t();
+      }
+   }
+}}
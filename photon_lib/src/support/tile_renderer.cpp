@@ -0,0 +1,112 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <photon/support/tile_renderer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cycfi { namespace photon
+{
+   namespace
+   {
+      struct tile
+      {
+         int               left, top, width, height;  // device pixels
+         cairo_surface_t*  surface = nullptr;
+      };
+
+      void rasterize(tile& t, canvas::display_list const& dl, double scale)
+      {
+         t.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, t.width, t.height);
+         cairo_surface_set_device_scale(t.surface, scale, scale);
+         auto context = cairo_create(t.surface);
+         {
+            canvas cnv{ *context };
+            cnv.replay(dl, { float(-t.left / scale), float(-t.top / scale) });
+         }
+         cairo_destroy(context);
+         cairo_surface_flush(t.surface);
+      }
+   }
+
+   tile_renderer::tile_renderer(std::size_t num_threads, int tile_size)
+    : _pool(num_threads)
+    , _tile_size(tile_size)
+   {}
+
+   void tile_renderer::render(
+      canvas& target
+    , canvas::display_list const& dl
+    , rect area
+   )
+   {
+      if (dl.empty() || area.width() <= 0 || area.height() <= 0)
+         return;
+
+      auto& context = target.cairo_context();
+      auto const scale = double(target.device_scale());
+
+      // The tiles, on the pixel grid at the target's scale
+      int const left = std::floor(area.left * scale);
+      int const top = std::floor(area.top * scale);
+      int const right = std::ceil(area.right * scale);
+      int const bottom = std::ceil(area.bottom * scale);
+
+      std::vector<tile> tiles;
+      for (int y = top; y < bottom; y += _tile_size)
+         for (int x = left; x < right; x += _tile_size)
+            tiles.push_back({
+               x, y, std::min(_tile_size, right - x), std::min(_tile_size, bottom - y)
+            });
+
+      // A copy of the display list per worker. The workers take the next
+      // tile to rasterize until there are none left.
+      auto const num_workers = std::min(_pool.num_threads(), tiles.size());
+      std::vector<canvas::display_list> recordings;
+      for (std::size_t i = 0; i != num_workers; ++i)
+         recordings.push_back(dl.copy());
+
+      // Rasterize them all on the pool, and wait
+      std::atomic<std::size_t> next{ 0 };
+      std::mutex mutex;
+      std::condition_variable done;
+      std::size_t pending = num_workers;
+      for (auto const& dl : recordings)
+      {
+         _pool.post(
+            [&, p = &dl]
+            {
+               for (auto i = next++; i < tiles.size(); i = next++)
+                  rasterize(tiles[i], *p, scale);
+               std::lock_guard<std::mutex> lock(mutex);
+               if (--pending == 0)
+                  done.notify_one();
+            }
+         );
+      }
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         done.wait(lock, [&]{ return pending == 0; });
+      }
+
+      // Composite
+      for (auto& t : tiles)
+      {
+         cairo_save(&context);
+         auto x = t.left / scale;
+         auto y = t.top / scale;
+         cairo_set_source_surface(&context, t.surface, x, y);
+         cairo_rectangle(&context, x, y, t.width / scale, t.height / scale);
+         cairo_fill(&context);
+         cairo_restore(&context);
+         cairo_surface_destroy(t.surface);
+      }
+   }
+}}
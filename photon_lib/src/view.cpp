@@ -70,15 +70,44 @@ namespace cycfi { namespace photon
       rect subj_bounds = { 0, 0, size_.x, size_.y };
       context ctx{ *this, cnv, &_content, subj_bounds };
 
-      // layout the subject only if the window bounds changes
-      if (subj_bounds != _current_bounds)
+      // layout the subject only if the window bounds or the display scale
+      // changes. Elements with scale dependent caches rebuild them in
+      // layout.
+      auto scale_ = scale();
+      if (subj_bounds != _current_bounds || scale_ != _current_scale)
       {
          _current_bounds = subj_bounds;
+         _current_scale = scale_;
          _content.layout(ctx);
       }
 
       // draw the subject
-      _content.draw(ctx);
+      if (_tiles)
+      {
+         auto dl = canvas::record(
+            [&](canvas& rcnv)
+            {
+               context rctx{ *this, rcnv, &_content, subj_bounds };
+               rctx.canvas.rect(_dirty);
+               rctx.canvas.clip();
+               _content.draw(rctx);
+            }
+          , cnv.device_scale()
+         );
+         _tiles->render(cnv, dl, _dirty);
+      }
+      else
+      {
+         _content.draw(ctx);
+      }
+   }
+
+   void view::tiled_rendering(bool enable, std::size_t num_threads)
+   {
+      if (!enable)
+         _tiles.reset();
+      else if (!_tiles || (num_threads && num_threads != _tiles->num_threads()))
+         _tiles.reset(new tile_renderer{ num_threads });
    }
 
    namespace
@@ -98,6 +127,18 @@ namespace cycfi { namespace photon
       }
    }
 
+   void view::refresh()
+   {
+      ++_refresh_count;
+      base_view::refresh();
+   }
+
+   void view::refresh(rect area)
+   {
+      ++_refresh_count;
+      base_view::refresh(area);
+   }
+
    void view::refresh(element& element)
    {
       call(
@@ -227,6 +268,17 @@ namespace cycfi { namespace photon
       refresh();
    }
 
+   void view::idle()
+   {
+      if (_content.empty())
+         return;
+
+      call(
+         [](auto const& ctx, auto& _content) { _content.idle(ctx); },
+         *this, _current_bounds
+      );
+   }
+
    void view::content(layers_type&& layers)
    {
       _content = std::forward<layers_type>(layers);